@@ -45,6 +45,9 @@
 #define VP_PWM0_OUT                 0x0092  // PWM0 Duty Cycle (R/W) [cite: 1700]
 #define VP_PWM1_OUT                 0x0093  // PWM1 Duty Cycle (R/W) [cite: 1703]
 
+// Flash (ICL/Font) upis iz RAM-a
+#define VP_FLASH_BLOCK_WRITE        0x00AA  // 32KB RAM -> Flash block write (W), D11 0x5A self-clears when done
+
 // --- Hardverske periferije i interfejsi ---
 #define VP_FSK_INTERFACE_START      0x0100  // FSK Bus Interface Start Address [cite: 2191]
 #define VP_CURVE_STATUS_START       0x0300  // Dynamic Curve Status Feedback [cite: 2185]
@@ -6,7 +6,103 @@
  */
 
 #include "sys.h" // Ukljucuje i T5LOS8051.h
-#include "DWIN_GUI_VP.H"
+#include "DWIN_GUI_VP.h"
+
+// =========================================================================
+// 1. PWM FUNKCIJE (Hardverski PWM0/PWM1)
+// =========================================================================
+
+/** @brief Zadnja upisana preciznost po kanalu (za PWM_Set_Duty), 0 = kanal nije podesen. */
+static u16 pwm_precision[2] = {0, 0};
+
+/**
+ * @brief Racuna djelilac i preciznost za trazenu PWM frekvenciju.
+ * @details f = PWM_BASE_CLOCK / (djelilac * preciznost). Bira najmanji djelilac
+ *          (1-255) s kojim preciznost stane u 16 bita, tj. najvecu rezoluciju
+ *          duty-ja za datu frekvenciju.
+ * @param freq_hz: Trazena frekvencija u Hz.
+ * @param div_ptr: Izlaz, djelilac (D3 od VP_PWMx_SET).
+ * @param prec_ptr: Izlaz, preciznost (D1:D0 od VP_PWMx_SET).
+ * @return u8 (0 - OK, 1 - Frekvencija van opsega)
+ */
+u8 PWM_Calc(u32 freq_hz, u8* div_ptr, u16* prec_ptr) {
+    u32 total;
+    u32 div;
+    u32 prec;
+
+    if (freq_hz == 0 || div_ptr == NULL || prec_ptr == NULL) {
+        return 1;
+    }
+
+    // Ukupan broj taktova baznog sata po periodi (zaokruzeno)
+    total = (PWM_BASE_CLOCK + freq_hz / 2) / freq_hz;
+
+    div = (total + 0xFFFE) / 0xFFFF;
+    if (div == 0) div = 1;
+    if (div > 0xFF) {
+        return 1; // Prespora frekvencija
+    }
+
+    prec = (total + div / 2) / div;
+    if (prec < 2 || prec > 0xFFFF) {
+        return 1; // Prebrza frekvencija
+    }
+
+    *div_ptr = (u8)div;
+    *prec_ptr = (u16)prec;
+    return 0;
+}
+
+/**
+ * @brief Postavlja samo duty cycle vec podesenog PWM kanala.
+ * @details Koristi VP_PWM0_OUT (0x0092) / VP_PWM1_OUT (0x0093).
+ * @param channel: PWM kanal (0 ili 1).
+ * @param duty_permille: Duty cycle u promilima (0 do 1000).
+ * @return u8 (0 - OK, 1 - Greska)
+ */
+u8 PWM_Set_Duty(u8 channel, u16 duty_permille) {
+    u8 buf[2];
+    u16 duty;
+
+    if (channel > 1 || pwm_precision[channel] == 0) {
+        return 1;
+    }
+    if (duty_permille > 1000) duty_permille = 1000;
+
+    duty = (u16)(((u32)pwm_precision[channel] * duty_permille + 500) / 1000);
+    buf[0] = (u8)(duty >> 8);
+    buf[1] = (u8)duty;
+    write_dgus_vp(channel ? VP_PWM1_OUT : VP_PWM0_OUT, buf, 2);
+    return 0;
+}
+
+/**
+ * @brief Podesava frekvenciju i duty cycle hardverskog PWM kanala.
+ * @details Koristi VP_PWM0_SET (0x0086) / VP_PWM1_SET (0x0088):
+ *          D3 = djelilac, D2 = 0x00, D1:D0 = preciznost. Zatim upisuje duty.
+ * @param channel: PWM kanal (0 ili 1).
+ * @param freq_hz: Frekvencija u Hz.
+ * @param duty_permille: Duty cycle u promilima (0 do 1000).
+ * @return u8 (0 - OK, 1 - Greska)
+ */
+u8 PWM_Set(u8 channel, u32 freq_hz, u16 duty_permille) {
+    u8 buf[4];
+    u8 div;
+    u16 prec;
+
+    if (channel > 1 || PWM_Calc(freq_hz, &div, &prec)) {
+        return 1;
+    }
+
+    buf[0] = div;
+    buf[1] = 0x00;
+    buf[2] = (u8)(prec >> 8);
+    buf[3] = (u8)prec;
+    write_dgus_vp(channel ? VP_PWM1_SET : VP_PWM0_SET, buf, 4);
+
+    pwm_precision[channel] = prec;
+    return PWM_Set_Duty(channel, duty_permille);
+}
 
 // =========================================================================
 // 2. ADC FUNKCIJE (Analog-to-Digital Converter)
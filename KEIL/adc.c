@@ -0,0 +1,89 @@
+/**
+ * @file adc.c
+ * @brief Multi-Channel ADC Sampler.
+ * @details Per channel the sampler keeps an oversampling accumulator and the IIR
+ *          state. The IIR state carries 8 fraction bits below the 16-bit ADC scale
+ *          so small steps are not lost to the shift: y += (x - y) >> ADC_IIR_SHIFT.
+ *          The first decimated value seeds the filter directly, which avoids a
+ *          slow ramp up from zero after reset.
+ */
+
+#include "adc.h"
+#include "DWIN_GUI_VP.h"
+
+#define ADC_IIR_FRAC    8   /**< Fraction bits of the filter state */
+
+/** @brief Oversampling accumulators (sum of up to 2^ADC_OVERSAMPLE_LOG2 samples). */
+static u32 adc_accu[ADC_CHANNELS];
+/** @brief IIR filter state, value << ADC_IIR_FRAC. */
+static u32 adc_filt[ADC_CHANNELS];
+/** @brief Samples in the current decimation block. */
+static u8 adc_count = 0;
+/** @brief Set once the filter holds a valid value. */
+static bit adc_valid = 0;
+
+/**
+ * @brief Reset the sampler.
+ */
+void ADC_Sampler_Init(void)
+{
+    u8 i;
+
+    for(i = 0; i < ADC_CHANNELS; i++)
+    {
+        adc_accu[i] = 0;
+        adc_filt[i] = 0;
+    }
+    adc_count = 0;
+    adc_valid = 0;
+}
+
+/**
+ * @brief Take one sample of all channels.
+ * @details The burst buffer is big-endian as in DGUS RAM and assembled byte by
+ *          byte. Every 2^ADC_OVERSAMPLE_LOG2 calls the averages enter the filter.
+ */
+void ADC_Sampler_Tick(void)
+{
+    u8 buf[ADC_CHANNELS * 2];
+    u8 i;
+    s32 x;
+
+    read_dgus_vp(VP_ADC_INSTANT, buf, ADC_CHANNELS * 2);
+
+    for(i = 0; i < ADC_CHANNELS; i++)
+    {
+        adc_accu[i] += ((u16)buf[i << 1] << 8) | buf[(i << 1) + 1];
+    }
+
+    if(++adc_count < (1 << ADC_OVERSAMPLE_LOG2)) return;
+    adc_count = 0;
+
+    for(i = 0; i < ADC_CHANNELS; i++)
+    {
+        // Decimated sample in filter scale
+        x = (s32)(adc_accu[i] << (ADC_IIR_FRAC - ADC_OVERSAMPLE_LOG2));
+        adc_accu[i] = 0;
+
+        if(!adc_valid) adc_filt[i] = (u32)x;
+        else adc_filt[i] += (x - (s32)adc_filt[i]) >> ADC_IIR_SHIFT;
+    }
+    adc_valid = 1;
+}
+
+/**
+ * @brief Latest filtered value of one channel.
+ * @param channel ADC channel (0 to 7)
+ * @param raw_value_ptr Filtered value, rounded to the 16-bit ADC scale
+ * @return u8 (0 - OK, 1 - Greska)
+ */
+u8 ADC_Get_Filtered(u8 channel, u16* raw_value_ptr)
+{
+    u32 y;
+
+    if(channel >= ADC_CHANNELS || raw_value_ptr == NULL || !adc_valid) return 1;
+
+    y = (adc_filt[channel] + (1 << (ADC_IIR_FRAC - 1))) >> ADC_IIR_FRAC;
+    *raw_value_ptr = (y > 0xFFFF) ? 0xFFFF : (u16)y;
+    return 0;
+}
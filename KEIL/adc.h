@@ -0,0 +1,42 @@
+/**
+ * @file adc.h
+ * @brief Multi-Channel ADC Sampler Header File.
+ * @details Reads all eight AD0-AD7 words of VP_ADC_INSTANT in one 16-byte DGUS
+ *          burst per ADC_Sampler_Tick(), averages ADC_OVERSAMPLE samples per
+ *          channel (decimation) and runs each decimated value through a first
+ *          order IIR low-pass. Consumers read the filtered values from XDATA;
+ *          only the sampler touches DGUS RAM.
+ */
+
+#ifndef __ADC_H__
+#define __ADC_H__
+
+#include "sys.h"
+
+// --- Configuration ---
+#define ADC_CHANNELS        8   /**< AD0-AD7 */
+#define ADC_SAMPLE_MS       10  /**< Tick period the main loop schedules ADC_Sampler_Tick() at */
+#define ADC_OVERSAMPLE_LOG2 3   /**< 2^3 = 8 raw samples per decimated value (80 ms) */
+#define ADC_IIR_SHIFT       2   /**< Filter weight 1/4 per decimated value (~320 ms time constant) */
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Reset the sampler; filtered values are invalid until the first decimation
+ */
+void ADC_Sampler_Init(void);
+
+/**
+ * @brief Take one sample of all channels (one VP_ADC_INSTANT burst read)
+ */
+void ADC_Sampler_Tick(void);
+
+/**
+ * @brief Latest filtered value of one channel, no bus access
+ * @param channel ADC channel (0 to 7)
+ * @param raw_value_ptr Filtered 16-bit value, same scale as VP_ADC_INSTANT
+ * @return u8 (0 - OK, 1 - Bad channel or no data yet)
+ */
+u8 ADC_Get_Filtered(u8 channel, u16* raw_value_ptr);
+
+#endif
@@ -0,0 +1,503 @@
+/**
+ * @file dgus.c
+ * @brief DGUS VP Burst Access Engine.
+ * @details Write-combining queue for DGUS RAM. Every queued VP word keeps its two
+ *          bytes and a byte-enable mask; entries stay sorted by VP address so the
+ *          flush walks them as contiguous runs of 32-bit OS words. A run costs one
+ *          address setup, then Auto-Increment steps through it with one APP_EN
+ *          handshake per OS word. The whole flush is one EA-off window.
+ *
+ *          The shadow RAM mirrors DGUS_SHADOW_WORDS VP words from DGUS_SHADOW_START.
+ *          A dirty bit set means DGUS RAM may differ from the shadow (power-up,
+ *          partial write, invalidation); a clean word whose value is rewritten
+ *          unchanged costs no bus access at all. Words the GUI core writes itself
+ *          (VPB_GUI_TABLE, generated by TOOLS/vp_bind.py from the touch controls
+ *          and the shared bindings) never become clean, so every write to them
+ *          goes out.
+ */
+
+#include "dgus.h"
+#include "prof.h"
+#include "vp_bind_table.h"
+#include "string.h"
+
+/**
+ * @brief One queued VP word.
+ * @details mask bit 1 = high byte valid, bit 0 = low byte valid.
+ */
+typedef struct
+{
+    u16 vp;
+    u8 hi;
+    u8 lo;
+    u8 mask;
+} dgus_queue_entry;
+
+static dgus_queue_entry dgus_queue[DGUS_QUEUE_SIZE];
+static u8 dgus_queue_len = 0;
+/** @brief Handshakes the queued calls would have cost through write_dgus_vp(). */
+static u16 dgus_queue_direct = 0;
+
+u32 dgus_tx_saved = 0;
+u32 dgus_shadow_hits = 0;
+
+/** @brief Shadow copy of the user VP range, big-endian as in DGUS RAM. */
+static u8 dgus_shadow[DGUS_SHADOW_WORDS * 2];
+/** @brief One bit per shadowed VP word, 1 = DGUS RAM content unknown. */
+static u8 dgus_shadow_dirty[DGUS_SHADOW_WORDS / 8];
+/** @brief One bit per shadowed VP word, 1 = the GUI core writes it (always dirty). */
+static u8 dgus_shadow_gui[DGUS_SHADOW_WORDS / 8];
+
+/** @brief VP ranges the GUI core writes: { VP, words }. */
+static code struct { u16 vp; u16 words; } dgus_gui_vps[VPB_GUI_COUNT] = VPB_GUI_TABLE;
+
+#define SHADOW_IS_DIRTY(w)  (dgus_shadow_dirty[(w) >> 3] & (0x01 << ((w) & 0x07)))
+#define SHADOW_SET_DIRTY(w) (dgus_shadow_dirty[(w) >> 3] |= (0x01 << ((w) & 0x07)))
+#define SHADOW_CLR_DIRTY(w) (dgus_shadow_dirty[(w) >> 3] &= ~(0x01 << ((w) & 0x07)) | dgus_shadow_gui[(w) >> 3])
+
+/**
+ * @brief Insert or merge one byte into the sorted queue.
+ * @param vp VP word address
+ * @param lane 0 = high byte, 1 = low byte
+ * @param dat Byte value
+ */
+static void queue_dgus_byte(u16 vp, u8 lane, u8 dat)
+{
+    u8 i, j;
+
+    // Find insertion point (queue is short, linear scan from the end is cheapest
+    // because writes tend to arrive in ascending order)
+    i = dgus_queue_len;
+    while(i > 0 && dgus_queue[i - 1].vp > vp) i--;
+
+    if(i == 0 || dgus_queue[i - 1].vp != vp)
+    {
+        if(dgus_queue_len >= DGUS_QUEUE_SIZE)
+        {
+            flush_dgus_vp();
+            i = 0;
+        }
+        for(j = dgus_queue_len; j > i; j--) dgus_queue[j] = dgus_queue[j - 1];
+        dgus_queue[i].vp = vp;
+        dgus_queue[i].mask = 0;
+        dgus_queue_len++;
+        i++;
+    }
+
+    // Later writes win
+    if(lane == 0) { dgus_queue[i - 1].hi = dat; dgus_queue[i - 1].mask |= 0x02; }
+    else          { dgus_queue[i - 1].lo = dat; dgus_queue[i - 1].mask |= 0x01; }
+}
+
+/**
+ * @brief Queue a write to DGUS Variable Pointer (VP) memory.
+ * @details Splits the buffer into VP word bytes, exactly as write_dgus_vp() lays
+ *          them out, and accounts the handshakes a direct write would have used.
+ * @param addr 16-bit VP Address
+ * @param vbuf Pointer to source buffer
+ * @param len Length of data in bytes
+ */
+void queue_dgus_vp(u32 addr, void* vbuf, u16 len)
+{
+    u8* buf = (u8*)vbuf;
+    u16 vp = (u16)addr;
+    u16 n = len;
+    u8 lane = 0;
+
+    if(len == 0) return;
+    if(!shadow_dgus_write(&addr, &buf, &len)) return;
+    vp = (u16)addr;
+    n = len;
+
+    // Keep a call in one flush where it fits, so the accounting below stays exact
+    if(dgus_queue_len + (len >> 1) + 2 > DGUS_QUEUE_SIZE) flush_dgus_vp();
+
+    // Direct cost: odd start word, full 4-byte words, tail
+    if(addr & 0x01) { dgus_queue_direct++; n = (n > 2) ? n - 2 : 0; }
+    dgus_queue_direct += (n >> 2) + ((n & 0x03) ? 1 : 0);
+
+    while(len--)
+    {
+        queue_dgus_byte(vp, lane, *buf++);
+        if(lane) vp++;
+        lane ^= 0x01;
+    }
+}
+
+/**
+ * @brief Drop queued bytes that a direct write is about to replace.
+ * @details Entries stay sorted; an odd `len` ends on a high byte, so the low
+ *          byte of that last word stays queued.
+ * @param addr 16-bit VP Address
+ * @param len Length of data in bytes
+ */
+void dgus_unqueue(u32 addr, u16 len)
+{
+    u16 vp = (u16)addr;
+    u16 last;
+    u8 i, j;
+
+    if(dgus_queue_len == 0 || len == 0) return;
+    last = vp + ((len - 1) >> 1);
+
+    for(i = 0, j = 0; i < dgus_queue_len; i++)
+    {
+        if(dgus_queue[i].vp >= vp && dgus_queue[i].vp <= last)
+        {
+            dgus_queue[i].mask &= ((len & 0x01) && dgus_queue[i].vp == last) ? 0x01 : 0x00;
+        }
+        if(dgus_queue[i].mask) dgus_queue[j++] = dgus_queue[i];
+    }
+    dgus_queue_len = j;
+}
+
+/**
+ * @brief Write all queued VP data in one burst.
+ * @details Entries sharing an OS word (even/odd VP pair) go out in the same
+ *          handshake; the address registers are only reprogrammed when a run
+ *          of consecutive OS words breaks.
+ */
+void flush_dgus_vp(void)
+{
+    u8 i = 0;
+    u8 mask;
+    u16 os_addr;
+    u16 next_os = 0;
+    u16 burst = 0;
+
+    if(dgus_queue_len == 0) return;
+
+    EA = 0;
+    PROF_EA_BEGIN();
+    ADR_INC = 0x01;
+
+    while(i < dgus_queue_len)
+    {
+        os_addr = dgus_queue[i].vp >> 1;
+
+        // Start a new run?
+        if(burst == 0 || os_addr != next_os)
+        {
+            ADR_H = 0x00;
+            ADR_M = (u8)(os_addr >> 8);
+            ADR_L = (u8)os_addr;
+        }
+
+        mask = 0x00;
+        if((dgus_queue[i].vp & 0x01) == 0)
+        {
+            DATA3 = dgus_queue[i].hi;
+            DATA2 = dgus_queue[i].lo;
+            mask = dgus_queue[i].mask << 2;
+            i++;
+        }
+        if(i < dgus_queue_len && dgus_queue[i].vp == ((os_addr << 1) | 0x01))
+        {
+            DATA1 = dgus_queue[i].hi;
+            DATA0 = dgus_queue[i].lo;
+            mask |= dgus_queue[i].mask;
+            i++;
+        }
+
+        RAMMODE = 0x80 | mask;
+        APP_EN = 1; while(APP_EN);
+
+        burst++;
+        next_os = os_addr + 1;
+    }
+
+    RAMMODE = 0x00;
+    PROF_EA_STAMP();
+    EA = 1;
+    PROF_EA_END(PROF_DGUS_FLUSH);
+
+    if(dgus_queue_direct > burst) dgus_tx_saved += dgus_queue_direct - burst;
+    dgus_queue_len = 0;
+    dgus_queue_direct = 0;
+}
+
+// =============================================================================
+//  IN-PLACE READ-MODIFY-WRITE
+// =============================================================================
+
+/**
+ * @brief Set up the address, read one VP word.
+ * @details Auto-Increment stays off, so the write-back needs no second address
+ *          setup. Leaves EA off (no ISR touches the address registers until
+ *          dgus_rmw_end()); the GUI core is not held off.
+ */
+static u16 dgus_rmw_begin(u32 addr)
+{
+    u32 os_addr = addr >> 1;
+
+    EA = 0;
+    PROF_EA_BEGIN();
+    ADR_H = (u8)(os_addr >> 16);
+    ADR_M = (u8)(os_addr >> 8);
+    ADR_L = (u8)os_addr;
+    ADR_INC = 0x00;
+    RAMMODE = 0xAF;
+    APP_EN = 1; while(APP_EN);
+    if(addr & 0x01) return ((u16)DATA1 << 8) | DATA0;
+    return ((u16)DATA3 << 8) | DATA2;
+}
+
+/**
+ * @brief Write back the bytes of `val` that differ from `old` and close the window.
+ */
+static void dgus_rmw_end(u32 addr, u16 old, u16 val)
+{
+    u8 mask = 0x00;
+
+    // Byte enables: bit 1 = high byte, bit 0 = low byte of the VP word
+    if((u8)(old >> 8) != (u8)(val >> 8)) mask |= 0x02;
+    if((u8)old != (u8)val) mask |= 0x01;
+
+    if(mask)
+    {
+        if(addr & 0x01)
+        {
+            DATA1 = (u8)(val >> 8);
+            DATA0 = (u8)val;
+        }
+        else
+        {
+            DATA3 = (u8)(val >> 8);
+            DATA2 = (u8)val;
+            mask <<= 2;
+        }
+        RAMMODE = 0x80 | mask;
+        APP_EN = 1; while(APP_EN);
+    }
+
+    RAMMODE = 0x00;
+    PROF_EA_STAMP();
+    EA = 1;
+    PROF_EA_END(PROF_DGUS_RMW);
+
+    // The word is known exactly now
+    if(addr >= DGUS_SHADOW_START && addr < DGUS_SHADOW_START + DGUS_SHADOW_WORDS)
+    {
+        shadow_dgus_put16((u16)(addr - DGUS_SHADOW_START), val);
+    }
+}
+
+/**
+ * @brief Read-modify-write one VP word with one address setup.
+ * @param addr 16-bit VP Address
+ * @param clr Bits to clear
+ * @param set Bits to set
+ * @param tgl Bits to toggle
+ * @return Word before the change
+ */
+u16 modify_dgus_vp(u32 addr, u16 clr, u16 set, u16 tgl)
+{
+    u16 old = dgus_rmw_begin(addr);
+
+    dgus_rmw_end(addr, old, ((old & ~clr) | set) ^ tgl);
+    return old;
+}
+
+/**
+ * @brief Compare-and-swap one VP word with one address setup.
+ * @param addr 16-bit VP Address
+ * @param expect Expected word
+ * @param val New word
+ * @return 1 if swapped, 0 otherwise
+ */
+u8 cas_dgus_vp(u32 addr, u16 expect, u16 val)
+{
+    u16 old = dgus_rmw_begin(addr);
+
+    if(old != expect) val = old;
+    dgus_rmw_end(addr, old, val);
+    return old == expect;
+}
+
+// =============================================================================
+//  SHADOW RAM
+// =============================================================================
+
+/**
+ * @brief Initialize the shadow RAM.
+ * @details XDATA is not cleared by the startup code, so every word starts dirty.
+ *          GUI-written words are marked so that SHADOW_CLR_DIRTY() keeps them dirty.
+ */
+void DGUS_Shadow_Init(void)
+{
+    u8 i;
+    u16 vp, end;
+
+    memset(dgus_shadow_dirty, 0xFF, sizeof(dgus_shadow_dirty));
+    memset(dgus_shadow_gui, 0x00, sizeof(dgus_shadow_gui));
+    for(i = 0; i < VPB_GUI_COUNT; i++)
+    {
+        end = dgus_gui_vps[i].vp + dgus_gui_vps[i].words;
+        for(vp = dgus_gui_vps[i].vp; vp < end; vp++)
+        {
+            if(DGUS_SHADOWED(vp, 1))
+            {
+                dgus_shadow_gui[(vp - DGUS_SHADOW_START) >> 3] |= 0x01 << ((vp - DGUS_SHADOW_START) & 0x07);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Mark shadowed VP words as unknown.
+ * @param addr 16-bit VP Address
+ * @param words Number of VP words
+ */
+void DGUS_Shadow_Invalidate(u32 addr, u16 words)
+{
+    while(words--)
+    {
+        if(addr >= DGUS_SHADOW_START && addr < DGUS_SHADOW_START + DGUS_SHADOW_WORDS)
+        {
+            SHADOW_SET_DIRTY((u16)(addr - DGUS_SHADOW_START));
+        }
+        addr++;
+    }
+}
+
+/**
+ * @brief Filter a pending write through the shadow RAM.
+ * @details Only writes lying completely inside the shadow are filtered. A word
+ *          counts as changed if it is dirty or any written byte differs; a word
+ *          written only partly stays dirty because its other byte is unknown.
+ * @param addr 16-bit VP Address (in/out)
+ * @param buf Data pointer (in/out)
+ * @param len Length of data in bytes (in/out)
+ * @return 0 if nothing needs to be written, 1 otherwise
+ */
+u8 shadow_dgus_write(u32* addr, u8** buf, u16* len)
+{
+    u8* src = *buf;
+    u8* dst;
+    u16 w, i;
+    u16 words = (*len + 1) >> 1;
+    u16 first = 0xFFFF;
+    u16 last = 0;
+    u8 changed;
+
+    if(*addr < DGUS_SHADOW_START || *addr + words > DGUS_SHADOW_START + DGUS_SHADOW_WORDS)
+    {
+        return 1;
+    }
+
+    w = (u16)(*addr - DGUS_SHADOW_START);
+    dst = &dgus_shadow[w << 1];
+
+    for(i = 0; i < words; i++, w++)
+    {
+        changed = SHADOW_IS_DIRTY(w) ? 1 : 0;
+        if(dst[0] != src[0]) { dst[0] = src[0]; changed = 1; }
+        if((i << 1) + 1 < *len)
+        {
+            if(dst[1] != src[1]) { dst[1] = src[1]; changed = 1; }
+            SHADOW_CLR_DIRTY(w);
+        }
+
+        if(changed)
+        {
+            if(first == 0xFFFF) first = i;
+            last = i;
+        }
+        else
+        {
+            dgus_shadow_hits++;
+        }
+        src += 2;
+        dst += 2;
+    }
+
+    if(first == 0xFFFF) return 0;
+
+    // Trim to the changed span
+    *addr += first;
+    *buf += first << 1;
+    i = (last + 1) << 1;
+    if(i > *len) i = *len;
+    *len = i - (first << 1);
+    return 1;
+}
+
+/**
+ * @brief Store one VP word in the shadow RAM.
+ * @details The word is clean afterwards.
+ * @param w Word index from DGUS_SHADOW_START
+ * @param val Word value
+ * @return 1 if nothing changed, 0 otherwise
+ */
+u8 shadow_dgus_put16(u16 w, u16 val)
+{
+    u8* dst = &dgus_shadow[w << 1];
+
+    if(!SHADOW_IS_DIRTY(w) && dst[0] == (u8)(val >> 8) && dst[1] == (u8)val) return 1;
+    dst[0] = (u8)(val >> 8);
+    dst[1] = (u8)val;
+    SHADOW_CLR_DIRTY(w);
+    return 0;
+}
+
+/**
+ * @brief Check whether a VP word has a queued write that is not flushed yet.
+ * @details The shadow already holds the queued value for such a word; DGUS RAM
+ *          only will after the flush.
+ */
+static u8 dgus_queued(u16 vp)
+{
+    u8 i = dgus_queue_len;
+
+    // Sorted by VP: scan from the end until the entries are below vp
+    while(i > 0 && dgus_queue[i - 1].vp >= vp)
+    {
+        if(dgus_queue[--i].vp == vp) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Refresh the shadow RAM from data just read from DGUS RAM.
+ * @details Fully read words become clean: the shadow now equals DGUS RAM.
+ *          Words with a queued write are left alone, the flush will still
+ *          change them.
+ * @param addr 16-bit VP Address
+ * @param buf Data that was read
+ * @param len Length of data in bytes
+ */
+void shadow_dgus_read(u32 addr, u8* buf, u16 len)
+{
+    u16 w;
+    u16 vp = (u16)addr;
+
+    if(addr < DGUS_SHADOW_START || addr + (len >> 1) > DGUS_SHADOW_START + DGUS_SHADOW_WORDS)
+    {
+        return;
+    }
+
+    w = (u16)(addr - DGUS_SHADOW_START);
+    while(len >= 2)
+    {
+        if(!dgus_queued(vp))
+        {
+            dgus_shadow[w << 1] = buf[0];
+            dgus_shadow[(w << 1) + 1] = buf[1];
+            SHADOW_CLR_DIRTY(w);
+        }
+        buf += 2;
+        len -= 2;
+        w++;
+        vp++;
+    }
+}
+
+/**
+ * @brief Refresh one shadowed VP word from a value just read.
+ * @param w Word index from DGUS_SHADOW_START
+ * @param val Word read from DGUS RAM
+ */
+void shadow_dgus_read16(u16 w, u16 val)
+{
+    if(!dgus_queued(w + DGUS_SHADOW_START)) shadow_dgus_put16(w, val);
+}
@@ -0,0 +1,282 @@
+/**
+ * @file dgus.h
+ * @brief DGUS VP Burst Access Engine Header File.
+ * @details Write-combining queue in front of the DGUS RAM interface. Small VP
+ *          writes issued during one main-loop pass are collected, sorted and
+ *          merged into contiguous runs, then flushed in a single interrupt-disabled
+ *          burst.
+ *
+ *          A shadow copy of the user VP range with per-word dirty bits lets
+ *          write_dgus_vp() and queue_dgus_vp() drop writes that would not change
+ *          DGUS RAM. VPs the GUI core writes itself (touch controls, shared
+ *          bindings, see vp_bind_table.h) are never filtered.
+ *
+ *          DGUS_READ_U16() / DGUS_WRITE_U16() / DGUS_WRITE_U32() are the direct
+ *          forms for a constant VP address: the address bytes, the data lanes and
+ *          the byte-enable mask are folded by the compiler, so a 2-byte access is
+ *          one address setup and one handshake with no u32 shifts, no generic
+ *          pointer and no length loop.
+ *
+ *          modify_dgus_vp() and cas_dgus_vp() change one VP word in place: read
+ *          and write-back share one address setup and one EA-off window, and the
+ *          write enables only the bytes that change (RAMMODE mask), so the other
+ *          byte and the neighbouring VP of the OS word are never rewritten. A
+ *          change is still a read handshake and a write handshake. They are not
+ *          atomic against the GUI core: EA = 0 only keeps this core's ISRs out,
+ *          and a GUI core write to a changing byte between the two handshakes
+ *          (the write setup, a few SFR accesses) is overwritten.
+ */
+
+#ifndef __DGUS_H__
+#define __DGUS_H__
+
+#include "sys.h"
+#include "prof.h"
+#include "DWIN_GUI_VP.h"
+
+// --- Configuration ---
+/** @brief Number of VP words the write queue can hold before it flushes itself. */
+#define DGUS_QUEUE_SIZE     32
+/** @brief First VP word mirrored in the shadow RAM. */
+#define DGUS_SHADOW_START   VP_USER_START_NO_CURVE
+/** @brief Number of mirrored VP words (0x1000-0x207F, ~9 KB XDATA incl. dirty bits). */
+#define DGUS_SHADOW_WORDS   0x1080
+
+// --- Constant-Address Access ---
+// `vp` must be a constant expression: every ((vp) ...) test below folds at
+// compile time and the untaken lane branch is dropped. An even VP is the high
+// half of its OS word (DATA3:DATA2), an odd VP the low half (DATA1:DATA0).
+
+/** @brief Load ADR_H/M/L with the OS word of a constant VP. */
+#define DGUS_ADDR(vp)                                           \
+    do {                                                        \
+        ADR_H = (u8)((u32)(vp) >> 17);                          \
+        ADR_M = (u8)((vp) >> 9);                                \
+        ADR_L = (u8)((vp) >> 1);                                \
+    } while(0)
+
+/** @brief Byte enables of one VP word within its OS word. */
+#define DGUS_LANES(vp)          (((vp) & 0x01) ? 0x03 : 0x0C)
+
+/** @brief Nonzero if `words` VP words from `vp` lie in the shadow RAM. */
+#define DGUS_SHADOWED(vp, words) \
+    ((vp) >= DGUS_SHADOW_START && (vp) + (words) <= DGUS_SHADOW_START + DGUS_SHADOW_WORDS)
+
+/**
+ * @brief Read one VP word at a constant address
+ * @param vp Constant VP address
+ * @param var u16 lvalue receiving the word
+ */
+#define DGUS_READ_U16(vp, var)                                  \
+    do {                                                        \
+        EA = 0;                                                 \
+        PROF_EA_BEGIN();                                        \
+        DGUS_ADDR(vp);                                          \
+        RAMMODE = 0xAF;                                         \
+        APP_EN = 1; while(APP_EN);                              \
+        if((vp) & 0x01) (var) = ((u16)DATA1 << 8) | DATA0;      \
+        else            (var) = ((u16)DATA3 << 8) | DATA2;      \
+        RAMMODE = 0x00;                                         \
+        PROF_EA_STAMP();                                        \
+        EA = 1;                                                 \
+        PROF_EA_END(PROF_DGUS_READ);                            \
+        if(DGUS_SHADOWED(vp, 1))                                \
+            shadow_dgus_read16((vp) - DGUS_SHADOW_START, (var)); \
+    } while(0)
+
+/**
+ * @brief Write one VP word at a constant address
+ * @details Filtered through the shadow RAM like write_dgus_vp(); a queued write
+ *          to the word is dropped so the next flush does not undo this one.
+ * @param vp Constant VP address
+ * @param val u16 value (evaluated once)
+ */
+#define DGUS_WRITE_U16(vp, val)                                 \
+    do {                                                        \
+        u16 dgus_v_ = (val);                                    \
+        if(!DGUS_SHADOWED(vp, 1) ||                             \
+           !shadow_dgus_put16((vp) - DGUS_SHADOW_START, dgus_v_)) \
+        {                                                       \
+            dgus_unqueue((vp), 2);                              \
+            EA = 0;                                             \
+            PROF_EA_BEGIN();                                    \
+            DGUS_ADDR(vp);                                      \
+            RAMMODE = 0x80 | DGUS_LANES(vp);                    \
+            if((vp) & 0x01) { DATA1 = (u8)(dgus_v_ >> 8); DATA0 = (u8)dgus_v_; } \
+            else            { DATA3 = (u8)(dgus_v_ >> 8); DATA2 = (u8)dgus_v_; } \
+            APP_EN = 1; while(APP_EN);                          \
+            RAMMODE = 0x00;                                     \
+            PROF_EA_STAMP();                                    \
+            EA = 1;                                             \
+            PROF_EA_END(PROF_DGUS_WRITE);                       \
+        }                                                       \
+        else dgus_shadow_hits++;                                \
+    } while(0)
+
+/**
+ * @brief Write two VP words (high word first) at a constant address
+ * @details An even VP is one full OS word (one handshake); an odd VP spans two
+ *          OS words and takes two, with Auto-Increment stepping between them.
+ * @param vp Constant VP address
+ * @param val u32 value (evaluated once)
+ */
+#define DGUS_WRITE_U32(vp, val)                                 \
+    do {                                                        \
+        u32 dgus_v_ = (val);                                    \
+        u8 dgus_same_ = 0;                                      \
+        if(DGUS_SHADOWED(vp, 2))                                \
+        {                                                       \
+            dgus_same_ = shadow_dgus_put16((vp) - DGUS_SHADOW_START, (u16)(dgus_v_ >> 16)); \
+            dgus_same_ &= shadow_dgus_put16((vp) + 1 - DGUS_SHADOW_START, (u16)dgus_v_);   \
+        }                                                       \
+        if(!dgus_same_)                                         \
+        {                                                       \
+            dgus_unqueue((vp), 4);                              \
+            EA = 0;                                             \
+            PROF_EA_BEGIN();                                    \
+            DGUS_ADDR(vp);                                      \
+            if((vp) & 0x01)                                     \
+            {                                                   \
+                ADR_INC = 0x01;                                 \
+                RAMMODE = 0x83;                                 \
+                DATA1 = (u8)(dgus_v_ >> 24); DATA0 = (u8)(dgus_v_ >> 16); \
+                APP_EN = 1; while(APP_EN);                      \
+                RAMMODE = 0x8C;                                 \
+                DATA3 = (u8)(dgus_v_ >> 8); DATA2 = (u8)dgus_v_; \
+            }                                                   \
+            else                                                \
+            {                                                   \
+                RAMMODE = 0x8F;                                 \
+                DATA3 = (u8)(dgus_v_ >> 24); DATA2 = (u8)(dgus_v_ >> 16); \
+                DATA1 = (u8)(dgus_v_ >> 8);  DATA0 = (u8)dgus_v_; \
+            }                                                   \
+            APP_EN = 1; while(APP_EN);                          \
+            RAMMODE = 0x00;                                     \
+            PROF_EA_STAMP();                                    \
+            EA = 1;                                             \
+            PROF_EA_END(PROF_DGUS_WRITE);                       \
+        }                                                       \
+        else dgus_shadow_hits += 2;                             \
+    } while(0)
+
+/** @brief Set the `m` bits of a VP word in place, returns the old word. */
+#define DGUS_BIT_SET(vp, m)     modify_dgus_vp((vp), 0, (m), 0)
+/** @brief Clear the `m` bits of a VP word in place, returns the old word. */
+#define DGUS_BIT_CLR(vp, m)     modify_dgus_vp((vp), (m), 0, 0)
+/** @brief Toggle the `m` bits of a VP word in place, returns the old word. */
+#define DGUS_BIT_TGL(vp, m)     modify_dgus_vp((vp), 0, 0, (m))
+
+// --- Global External Variables ---
+/** @brief APP_EN handshakes saved by write-combining (direct writes minus burst writes). */
+extern u32 dgus_tx_saved;
+/** @brief VP words whose write was dropped because the shadow already held the value. */
+extern u32 dgus_shadow_hits;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Queue a write to DGUS Variable Pointer (VP) memory
+ * @details Same arguments as write_dgus_vp(). The data is copied, the write
+ *          reaches DGUS RAM on the next flush_dgus_vp().
+ * @param addr 16-bit VP Address
+ * @param buf Data pointer
+ * @param len Length of data in bytes
+ */
+void queue_dgus_vp(u32 addr, void* buf, u16 len);
+
+/**
+ * @brief Drop queued bytes that a direct write replaces
+ * @details Called by write_dgus_vp() and the DGUS_WRITE_* macros for the bytes
+ *          they actually write, so a later flush_dgus_vp() cannot restore the
+ *          older queued value behind the shadow's back.
+ * @param addr 16-bit VP Address
+ * @param len Length of data in bytes
+ */
+void dgus_unqueue(u32 addr, u16 len);
+
+/**
+ * @brief Write all queued VP data in one burst
+ * @details Call once per main-loop pass. Reads issued before the flush do not
+ *          see queued data.
+ */
+void flush_dgus_vp(void);
+
+/**
+ * @brief Read-modify-write one VP word with one address setup
+ * @details new = ((old & ~clr) | set) ^ tgl. One read handshake, plus one write
+ *          handshake only if a byte changes; not atomic against the GUI core
+ *          (see above). Queued writes to the word that have not been flushed yet
+ *          are not seen.
+ * @param addr 16-bit VP Address
+ * @param clr Bits to clear
+ * @param set Bits to set
+ * @param tgl Bits to toggle
+ * @return Word before the change
+ */
+u16 modify_dgus_vp(u32 addr, u16 clr, u16 set, u16 tgl);
+
+/**
+ * @brief Compare-and-swap one VP word with one address setup
+ * @details Writes `val` only if the word held `expect` at the read. A GUI core
+ *          write between the read and the write handshake is overwritten by
+ *          `val` (see above); for a flag the GUI sets and the firmware clears,
+ *          a second set inside that window is lost.
+ * @param addr 16-bit VP Address
+ * @param expect Expected word
+ * @param val New word
+ * @return 1 if swapped, 0 if the word differed (nothing written)
+ */
+u8 cas_dgus_vp(u32 addr, u16 expect, u16 val);
+
+/**
+ * @brief Initialize the shadow RAM (every word dirty, i.e. unknown)
+ */
+void DGUS_Shadow_Init(void);
+
+/**
+ * @brief Mark shadowed VP words as unknown so the next write goes out
+ * @details Use for VPs the GUI core may change on its own that are not in
+ *          VPB_GUI_TABLE (those are never filtered), when the firmware writes
+ *          them without reading first.
+ * @param addr 16-bit VP Address
+ * @param words Number of VP words
+ */
+void DGUS_Shadow_Invalidate(u32 addr, u16 words);
+
+/**
+ * @brief Filter a pending write through the shadow RAM
+ * @details Updates the shadow and trims addr/buf/len to the span of words that
+ *          actually change. Addresses outside the shadow pass through unchanged.
+ * @param addr 16-bit VP Address (in/out)
+ * @param buf Data pointer (in/out)
+ * @param len Length of data in bytes (in/out)
+ * @return 0 if nothing needs to be written, 1 otherwise
+ */
+u8 shadow_dgus_write(u32* addr, u8** buf, u16* len);
+
+/**
+ * @brief Store one VP word in the shadow RAM
+ * @details Backs the constant-address macros above.
+ * @param w Word index from DGUS_SHADOW_START
+ * @param val Value now in (or about to be written to) DGUS RAM
+ * @return 1 if the shadow already held `val` as a clean word, 0 otherwise
+ */
+u8 shadow_dgus_put16(u16 w, u16 val);
+
+/**
+ * @brief Refresh one shadowed VP word from a value just read
+ * @details Backs DGUS_READ_U16(); skipped while the word has a queued write.
+ * @param w Word index from DGUS_SHADOW_START
+ * @param val Word read from DGUS RAM
+ */
+void shadow_dgus_read16(u16 w, u16 val);
+
+/**
+ * @brief Refresh the shadow RAM from data just read from DGUS RAM
+ * @param addr 16-bit VP Address
+ * @param buf Data that was read
+ * @param len Length of data in bytes
+ */
+void shadow_dgus_read(u32 addr, u8* buf, u16 len);
+
+#endif
@@ -0,0 +1,186 @@
+/**
+ * @file flash.c
+ * @brief Asynchronous Flash Block Write Engine.
+ * @details One block is in flight on the GUI core at a time, up to
+ *          FLASH_QUEUE_SIZE more wait in a small ring. Completion is detected by
+ *          reading back the command word every FLASH_POLL_MS: the GUI core clears
+ *          the 0x5A enable byte when the 32 KB are in flash, so the next block
+ *          starts as soon as the previous one is done instead of after a worst
+ *          case sleep. A timeout never issues over a command the GUI core still
+ *          owns: the job stops and the engine waits for the enable byte.
+ */
+
+#include "flash.h"
+#include "dgus.h"
+#include "uart.h"
+#include "DWIN_GUI_VP.h"
+
+flash_stat Flash_Stats;
+
+static u16 flash_q_block[FLASH_QUEUE_SIZE];
+static u16 flash_q_src[FLASH_QUEUE_SIZE];
+static u8 flash_q_head;
+static u8 flash_q_count;
+
+static u8 flash_busy;       // A block is being written by the GUI core
+static u8 flash_stuck;      // A timed-out block is still enabled, buffers locked
+static u16 flash_cur_src;   // Its source buffer
+static u16 flash_blk_start; // Wait_Count when it was issued
+static u16 flash_job_start; // Wait_Count when the engine left idle
+static u16 flash_poll_last;
+
+/**
+ * @brief Take the oldest queued block and hand it to the GUI core.
+ */
+static void flash_issue(void)
+{
+    u8 cmd[12];
+    u16 block = flash_q_block[flash_q_head];
+
+    flash_cur_src = flash_q_src[flash_q_head];
+    flash_q_head = (flash_q_head + 1) % FLASH_QUEUE_SIZE;
+    flash_q_count--;
+
+    // D11:D10 Enable (0x5A) & Mode (0x02 - Write 32KB)
+    cmd[0] = 0x5A;
+    cmd[1] = 0x02;
+    // D9:D8 Flash block, D7:D6 source RAM (VP)
+    cmd[2] = (u8)(block >> 8);
+    cmd[3] = (u8)block;
+    cmd[4] = (u8)(flash_cur_src >> 8);
+    cmd[5] = (u8)flash_cur_src;
+    // D5:D4 GUI core wait after the write, D3:D0 reserved
+    cmd[6] = (u8)(FLASH_CMD_DELAY_MS >> 8);
+    cmd[7] = (u8)FLASH_CMD_DELAY_MS;
+    cmd[8] = 0x00;
+    cmd[9] = 0x00;
+    cmd[10] = 0x00;
+    cmd[11] = 0x00;
+    write_dgus_vp(VP_FLASH_BLOCK_WRITE, cmd, 12);
+
+    flash_busy = 1;
+    flash_blk_start = Wait_Count;
+    flash_poll_last = Wait_Count;
+}
+
+u8 Flash_Submit(u16 block, u16 src_vp)
+{
+    u8 slot;
+
+    if(flash_stuck || flash_q_count >= FLASH_QUEUE_SIZE) return 1;
+
+    if(!flash_busy && flash_q_count == 0)
+    {
+        // New job: statistics restart
+        Flash_Stats.blocks = 0;
+        Flash_Stats.errors = 0;
+        Flash_Stats.busy_ms = 0;
+        Flash_Stats.block_ms_max = 0;
+        Flash_Stats.block_ms_last = 0;
+        flash_job_start = Wait_Count;
+    }
+
+    slot = (flash_q_head + flash_q_count) % FLASH_QUEUE_SIZE;
+    flash_q_block[slot] = block;
+    flash_q_src[slot] = src_vp;
+    flash_q_count++;
+
+    if(!flash_busy) flash_issue();
+    return 0;
+}
+
+u8 Flash_Buffer_Used(u16 vp)
+{
+    u8 i;
+
+    if(flash_stuck) return 1;
+    if(flash_busy && flash_cur_src == vp) return 1;
+    for(i = 0; i < flash_q_count; i++)
+    {
+        if(flash_q_src[(flash_q_head + i) % FLASH_QUEUE_SIZE] == vp) return 1;
+    }
+    return 0;
+}
+
+u16 Flash_Free_Buffer(void)
+{
+    if(!Flash_Buffer_Used(FLASH_BUF0_VP)) return FLASH_BUF0_VP;
+    if(!Flash_Buffer_Used(FLASH_BUF1_VP)) return FLASH_BUF1_VP;
+    return 0;
+}
+
+void Flash_Poll(void)
+{
+    u16 state;
+    u16 elapsed;
+
+    if(!flash_busy && !flash_stuck) return;
+    if((u16)(Wait_Count - flash_poll_last) < FLASH_POLL_MS) return;
+    flash_poll_last = Wait_Count;
+
+    DGUS_READ_U16(VP_FLASH_BLOCK_WRITE, state);
+    if(flash_stuck)
+    {
+        // The GUI core let go of the timed-out command: buffers free again
+        if((state >> 8) != 0x5A) flash_stuck = 0;
+        return;
+    }
+
+    elapsed = Wait_Count - flash_blk_start;
+    Flash_Stats.busy_ms = Wait_Count - flash_job_start;
+    if((state >> 8) == 0x5A && elapsed < FLASH_TIMEOUT_MS) return;
+
+    Flash_Stats.block_ms_last = elapsed;
+    if(elapsed > Flash_Stats.block_ms_max) Flash_Stats.block_ms_max = elapsed;
+    flash_busy = 0;
+
+    if((state >> 8) == 0x5A)
+    {
+        // Stuck: the command and its buffer may still be in use, so nothing is
+        // issued over it. The job ends here, the queued blocks are dropped.
+        Flash_Stats.errors++;
+        flash_q_count = 0;
+        flash_stuck = 1;
+        return;
+    }
+
+    Flash_Stats.blocks++;
+    if(flash_q_count) flash_issue();
+}
+
+u8 Flash_Idle(void)
+{
+    return !flash_busy && flash_q_count == 0;
+}
+
+/**
+ * @brief Send a decimal number over UART5.
+ */
+static void flash_put_dec(u32 v)
+{
+    u8 txt[10];
+    u8 n = 0;
+
+    do
+    {
+        txt[n++] = (u8)(v % 10) + '0';
+        v /= 10;
+    } while(v);
+    while(n) UART5_Sendbyte(txt[--n]);
+}
+
+void Flash_Report(void)
+{
+    UART5_SendStr("FLASH blk=", 10);
+    flash_put_dec(Flash_Stats.blocks);
+    UART5_SendStr(" err=", 5);
+    flash_put_dec(Flash_Stats.errors);
+    UART5_SendStr(" ms=", 4);
+    flash_put_dec(Flash_Stats.busy_ms);
+    UART5_SendStr(" max=", 5);
+    flash_put_dec(Flash_Stats.block_ms_max);
+    // 32 KB per block: KB/s = blocks * 32 * 1000 / ms
+    UART5_SendStr(" KB/s=", 6);
+    flash_put_dec(Flash_Stats.busy_ms ? (u32)Flash_Stats.blocks * 32000UL / Flash_Stats.busy_ms : 0);
+    UART5_SendStr("\r\n", 2);
+}
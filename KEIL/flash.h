@@ -0,0 +1,98 @@
+/**
+ * @file flash.h
+ * @brief Asynchronous Flash Block Write Engine Header File.
+ * @details Writes 32 KB blocks from DGUS RAM to the display's NOR flash (ICL,
+ *          font and data libraries) through VP_FLASH_BLOCK_WRITE (0x00AA). The GUI
+ *          core clears the 0x5A enable byte when a block is done; the engine polls
+ *          that byte instead of sleeping a fixed time and issues the next queued
+ *          block at once.
+ *
+ *          Two RAM staging buffers allow pipelining: while the GUI core writes one
+ *          buffer, the producer (UART download, test pattern) fills the other.
+ *          Flash_Poll() must be called from the main loop; it costs nothing while
+ *          the engine is idle.
+ *
+ *          A block still enabled after FLASH_TIMEOUT_MS fails the job: the queue
+ *          is dropped and the engine is idle with Flash_Stats.errors set, but the
+ *          GUI core may still own the command and read the staging buffers, so
+ *          both stay locked and Flash_Submit() refuses until it clears the enable
+ *          byte.
+ */
+
+#ifndef __FLASH_H__
+#define __FLASH_H__
+
+#include "sys.h"
+
+// --- Configuration ---
+#define FLASH_BLOCK_BYTES   32768UL     /**< Bytes per flash block / command */
+#define FLASH_BLOCK_WORDS   0x4000      /**< VP words per block */
+#define FLASH_BUF0_VP       0x8000      /**< Staging buffer 0 (VP 0x8000-0xBFFF) */
+#define FLASH_BUF1_VP       0xC000      /**< Staging buffer 1 (VP 0xC000-0xFFFF) */
+#define FLASH_QUEUE_SIZE    2           /**< Blocks queued behind the one being written */
+#define FLASH_POLL_MS       2           /**< Completion poll interval */
+#define FLASH_TIMEOUT_MS    2000        /**< A block taking longer fails the job */
+#define FLASH_CMD_DELAY_MS  100         /**< D5:D4 of the command: GUI core settle time after the write (0x64) */
+
+// --- Structures ---
+/**
+ * @brief Flash Engine Statistics
+ * @details busy_ms runs from the first command of a job until the engine is
+ *          idle again; throughput = bytes / busy_ms (bytes per ms = KB/s).
+ */
+typedef struct _flash_stat
+{
+    u16 blocks;         // Blocks written in the current/last job
+    u16 errors;         // Blocks that timed out (the job stops at the first)
+    u16 busy_ms;        // Job duration so far
+    u16 block_ms_max;   // Slowest single block
+    u16 block_ms_last;  // Last block
+} flash_stat;
+
+// --- Global External Variables ---
+extern flash_stat Flash_Stats;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Queue one 32 KB block write
+ * @param block Flash block number (32 KB units, e.g. ICL id * 8 + n)
+ * @param src_vp DGUS RAM source of the 32 KB (word address)
+ * @return 0 queued, 1 queue full (call Flash_Poll() and retry) or a timed-out
+ *         block still holds the GUI core
+ */
+u8 Flash_Submit(u16 block, u16 src_vp);
+
+/**
+ * @brief Staging buffer that is neither being written nor queued
+ * @return VP of a free 32 KB buffer, or 0 if both are in use
+ */
+u16 Flash_Free_Buffer(void);
+
+/**
+ * @brief Check one staging buffer
+ * @param vp FLASH_BUF0_VP or FLASH_BUF1_VP
+ * @return 1 if it is being written, waits in the queue, or a timed-out block
+ *         still holds the GUI core
+ */
+u8 Flash_Buffer_Used(u16 vp);
+
+/**
+ * @brief Advance the engine: detect completion, issue the next block, release
+ *        the buffers once a timed-out block is given up by the GUI core
+ */
+void Flash_Poll(void);
+
+/**
+ * @brief Engine state
+ * @return 1 if no block is being written or queued (also after a timeout,
+ *         check Flash_Stats.errors)
+ */
+u8 Flash_Idle(void);
+
+/**
+ * @brief Send the statistics of the last job over UART5 (text)
+ */
+void Flash_Report(void);
+
+#endif
@@ -10,38 +10,47 @@
 
 #include "sys.h"
 #include "uart.h"
-#include "DWIN_GUI_VP.H"
-#include <math.h> // Potrebno za log() funkciju
+#include "dgus.h"
+#include "proto.h"
+#include "sched.h"
+#include "ntc.h"
+#include "adc.h"
+#include "touch.h"
+#include "prof.h"
+#include "pt.h"
+#include "flash.h"
+#include "update.h"
+#include "page.h"
+#include "vp_bind.h"
+#include "DWIN_GUI_VP.h"
 #include <stdio.h> // Za sprintf ako zatreba, ali radimo rucno radi brzine
 
-extern u8 ADC_Read_Raw(u8 channel, u16* raw_value_ptr);
 extern u8 LED_Set_Brightness_Now(u8 brightness);
+extern u8 PWM_Set(u8 channel, u32 freq_hz, u16 duty_permille);
+
+// Scheduler task numbers (see sched.h)
+#define TASK_BUTTON     0
+#define TASK_TOUCH      1
+#define TASK_P1         2
+#define TASK_ICON_DND   3
+#define TASK_ICON_HMD   4
+#define TASK_IMAGE      5
+#define TASK_NTC        6
+#define TASK_ADC        7
+
+// Touch hot zones (see touch.h)
+#define ZONE_HIDDEN_MENU    0
 
 // Global variables
 /** @brief Counter variable incremented by button press. */
 u16 my_variable = 0;
-/** @brief Variable to store the button state read from DGUS VP. */
-u16 button_val = 0;
-/** @brief Timestamp for the last keep-alive message sent. */
-u16 last_keep_alive = 0;
-/** @brief Timestamp for P1 update. */
-u16 last_p1_update = 0;
 /** @brief Counter for Port 1. */
 u8 p1_cnt = 0;
 
 // ADC i Temperatura
 u16 adc1_raw_val = 0;
-float calculated_temp = 0.0f;
-s16 temp_int_for_vp = 0; // Signed integer za VP (x100)
-
-// Hidden Button / Long Press Logic
-u32 start_vrijeme = 0; 
-u8 mjerenje_aktivno = 0; 
-u8 okinuto = 0; 
-u8 status;       // Touch Status
-u16 x_pos;       // Touch X
-u16 y_pos;       // Touch Y
-u8 tp_dump[7];   // Touch Raw Buffer
+s16 calculated_temp = 0; // Temperatura u 0.01 C (NTC_GetTemperature)
+s16 temp_int_for_vp = 0; // Signed integer za VP (cijeli stepeni)
 
 // Pomocna funkcija za slanje jednog bajta kao HEX (npr. 0xA5 ispisuje "A5 ")
 void UART_Send_Hex(u8 b)
@@ -57,35 +66,6 @@ void UART_Send_Hex(u8 b)
 
     UART5_Sendbyte(' '); // Razmak za citljivost
 }
-// --- Funkcija za kalkulaciju temperature ---
-// Prilagodjena za C51 i T5L 16-bitni ADC
-static float ROOM_GetTemperature(u16 adc_value)
-{
-    float temperature;
-    float ntc_resistance;
-    float adc_float = (float)adc_value;
-
-    // Zastita od dijeljenja sa nulom (ako je ADC max, otpor je beskonacan/prekid)
-    if(adc_value >= 65534) return -99.99f; // Greska senzor otvoren
-    if(adc_value == 0) return 99.99f;      // Greska senzor kratak spoj
-
-    // Kalkulacija otpora NTC-a
-    // Formula prilagodjena za 16-bit ADC (65535 umjesto 4095)
-    // Tvoja formula: Pullup * ((Max / (Max - Val)) - 1)
-    // Ovo pretpostavlja da ADC mjeri napon na NTC-u (donji otpornik)
-    ntc_resistance = AMBIENT_NTC_PULLUP * ((65535.0f / (65535.0f - adc_float)) - 1.0f);
-
-    // Steinhart-Hart (Beta) jednacina
-    // T = B / (B/To + ln(R/Ro))
-    // 298.15f = 25 stepeni Celzijusa u Kelvinima
-    // 273.15f = Konverzija Kelvin -> Celzijus
-    temperature = (AMBIENT_NTC_B_VALUE * 298.15f) /
-                  (AMBIENT_NTC_B_VALUE + (298.15f * log(ntc_resistance / AMBIENT_NTC_RREF)));
-
-    temperature = temperature - 273.15f;
-
-    return temperature;
-}
 
 
 void Update_GUI_RTC(void)
@@ -113,10 +93,11 @@ void Update_GUI_RTC(void)
 }
 
 // Funkcija za "Samounitenje" (Flash Overwrite Test)
-void Self_Destruct_Test(void)
+// Protothread (pt.h): zove se iz glavne petlje, cekanja ne blokiraju petlju
+u8 Self_Destruct_Test(void)
 {
-    // Staticka varijabla da osigura da se ovo desi samo jednom
-    static bit is_triggered = 0;
+    // Kontekst protothread-a; nakon reseta komande ostaje parkiran zauvijek
+    static pt self_pt = {0, 0};
 
     // Bufferi za komande
     u8 update_cmd[4];
@@ -124,126 +105,213 @@ void Self_Destruct_Test(void)
 
     // Provjera tajmera: Da li je prolo 20.000 ms (20 sekundi)?
     // Wait_Count se inkrementira u sys.c svakih 1ms
-    if (!is_triggered && Wait_Count >= 20000)
+    PT_BEGIN(&self_pt);
+
+    PT_WAIT_UNTIL(&self_pt, Wait_Count >= 20000);
+
+    // --- KORAK 1: Priprema komande za Update Koda (VP 0x06) ---
+    // D3 = 0x5A: Enable / Trigger
+    // D2 = 0xA5: Mode 0xA5 (Update User 8051 Code, 64KB block)
+    // D1 = 0x10: Source Address High Byte (VP 0x1000)
+    // D0 = 0x00: Source Address Low Byte
+    update_cmd[0] = 0x5A;
+    update_cmd[1] = 0xA5;
+    update_cmd[2] = 0x10;
+    update_cmd[3] = 0x00;
+
+    // Opcionalno: Poalji poruku na UART da znamo da pocinje kraj
+    // UART5_SendStr("Bye Bye! Flashing garbage...\r\n", 28);
+
+    // --- KORAK 2: Izvri Flash Update ---
+    // U ovom trenutku hardver pauzira CPU, brie Flash i upisuje
+    // sadraj sa adrese RAM 0x1000 u Code Flash.
+    write_dgus_vp(0x0006, update_cmd, 4);
+
+    // --- KORAK 3: Sigurnosno cekanje ---
+    // Iako je CPU pauziran hardverski, dodajemo delay da budemo sigurni
+    // da se nita ne desi prije nego to je Flash stabilan.
+    PT_SLEEP(&self_pt, 1000);
+
+    // --- KORAK 4: Sistemski Reset (VP 0x04) ---
+    // D3-D0 = 0x55, 0xAA, 0x5A, 0xA5
+    reset_cmd[0] = 0x55;
+    reset_cmd[1] = 0xAA;
+    reset_cmd[2] = 0x5A;
+    reset_cmd[3] = 0xA5;
+
+    write_dgus_vp(0x0004, reset_cmd, 4);
+
+    // Nakon ovoga, uredaj se resetuje.
+    // Hardver kopira NOVI (vjerovatno neispravan) sadraj iz Flasha u RAM.
+    // Uredaj se vie nece upaliti kako treba.
+    PT_WAIT_UNTIL(&self_pt, 0);
+
+    PT_END(&self_pt);
+}
+
+// Stanje testa slika/ikonica (dijele ga tri taska ispod)
+static u16 current_image_id = 0; // Ciljna slika (0 ili 1), potvrdjena je Page_Now
+static u16 val_dnd = 0;          // Vrijednost za VP_ICON_DND
+static u16 val_hmd = 0;          // Vrijednost za VP_ICON_HMD
+
+// --- Task: promjena slike (Svakih 5000ms) ---
+void Test_Image_Switch(void)
+{
+    // Prethodna promjena jo nije potvrdjena (VP_PIC_NOW)
+    if(Page_Begin(current_image_id ? 0 : 1)) return;
+
+    // Prebaci ID slike: 0 -> 1 -> 0
+    if(current_image_id == 0) current_image_id = 1;
+    else current_image_id = 0;
+
+    // Slika 00 se prikazuje odmah sa aktuelnim ikonicama
+    if(current_image_id == 0)
     {
-        is_triggered = 1; // Blokiraj ponovno izvravanje
-
-        // --- KORAK 1: Priprema komande za Update Koda (VP 0x06) ---
-        // D3 = 0x5A: Enable / Trigger
-        // D2 = 0xA5: Mode 0xA5 (Update User 8051 Code, 64KB block)
-        // D1 = 0x10: Source Address High Byte (VP 0x1000)
-        // D0 = 0x00: Source Address Low Byte
-        update_cmd[0] = 0x5A;
-        update_cmd[1] = 0xA5;
-        update_cmd[2] = 0x10;
-        update_cmd[3] = 0x00;
-
-        // Opcionalno: Poalji poruku na UART da znamo da pocinje kraj
-        // UART5_SendStr("Bye Bye! Flashing garbage...\r\n", 28);
-
-        // --- KORAK 2: Izvri Flash Update ---
-        // U ovom trenutku hardver pauzira CPU, brie Flash i upisuje
-        // sadraj sa adrese RAM 0x1000 u Code Flash.
-        write_dgus_vp(0x0006, update_cmd, 4);
-
-        // --- KORAK 3: Sigurnosno cekanje ---
-        // Iako je CPU pauziran hardverski, dodajemo delay da budemo sigurni
-        // da se nita ne desi prije nego to je Flash stabilan.
-        delay_ms(1000);
-
-        // --- KORAK 4: Sistemski Reset (VP 0x04) ---
-        // D3-D0 = 0x55, 0xAA, 0x5A, 0xA5
-        reset_cmd[0] = 0x55;
-        reset_cmd[1] = 0xAA;
-        reset_cmd[2] = 0x5A;
-        reset_cmd[3] = 0xA5;
-
-        write_dgus_vp(0x0004, reset_cmd, 4);
-
-        // Nakon ovoga, uredaj se resetuje.
-        // Hardver kopira NOVI (vjerovatno neispravan) sadraj iz Flasha u RAM.
-        // Uredaj se vie nece upaliti kako treba.
+        Vpb_Set(VPB_ICON_DND, val_dnd);
+        Vpb_Set(VPB_ICON_HMD, val_hmd);
+        Vpb_Sync();
     }
+
+    // Ikonice u jednom burst-u, tek onda komanda za promjenu slike (VP 0x0084)
+    Page_Commit();
 }
-// Strukura za 0x0084 komandu (2 Worda = 4 Bajta)
-typedef struct {
-    u16 enable_mode; // 0x5A01
-    u16 pic_id;      // 0x0000 ili 0x0001
-} pic_set_cmd;
 
-void Test_Image_Switch(void)
+// --- Task: iconDND na VP_ICON_DND (Svakih 400ms, samo ako je slika 00 aktivna) ---
+void Test_Icon_DND(void)
 {
-    // Staticke varijable pamte stanje izmedu poziva funkcije
-    static u16 last_img_time = 0; // Tajmer za sliku (5s)
-    static u16 last_dnd_time = 0; // Tajmer za DND (400ms)
-    static u16 last_hmd_time = 0; // Tajmer za HMD (900ms)
+    if(Page_Now != 0 || Page_Pending()) return;
 
-    static u16 current_image_id = 0; // Trenutna slika (0 ili 1)
-    static u16 val_dnd = 0;          // Vrijednost za VP 0x1030
-    static u16 val_hmd = 0;          // Vrijednost za VP 0x1040
+    // Toggle vrijednost 0 <-> 1
+    if(val_dnd == 0) val_dnd = 1;
+    else val_dnd = 0;
 
-    pic_set_cmd command;
+    // Upis na VP_ICON_DND (ide van sa Vpb_Sync)
+    Vpb_Set(VPB_ICON_DND, val_dnd);
+}
 
-    // --- 1. Logika za promjenu slike (Svakih 5000ms) ---
-    // Koristimo Wait_Count koji se inkrementira u sys.c (T0_ISR)
-    if((u16)(Wait_Count - last_img_time) >= 5000)
+// --- Task: iconHMD na VP_ICON_HMD (Svakih 900ms, samo ako je slika 00 aktivna) ---
+void Test_Icon_HMD(void)
+{
+    if(Page_Now != 0 || Page_Pending()) return;
+
+    // Toggle vrijednost 0 <-> 1
+    if(val_hmd == 0) val_hmd = 1;
+    else val_hmd = 0;
+
+    // Upis na VP_ICON_HMD (ide van sa Vpb_Sync)
+    Vpb_Set(VPB_ICON_HMD, val_hmd);
+}
+
+// --- Task: P1 brojac i osvjetljenje (Svakih 100ms) ---
+static void Task_P1_Update(void)
+{
+    P1 = p1_cnt++;
+    LED_Set_Brightness_Now(p1_cnt/3);
+}
+
+// --- Task: Keep Alive + NTC mjerenje (Svake 2 sekunde) ---
+static void Task_NTC_Report(void)
+{
+    // 1. Procitaj filtriranu ADC vrijednost (Kanal 1 - gdje je NTC spojen)
+    if(ADC_Get_Filtered(1, &adc1_raw_val) == 0)
     {
-        last_img_time = Wait_Count; // Resetuj tajmer za sliku
+        // 2. Izracunaj temperaturu (tabela, bez float/log)
+        calculated_temp = NTC_GetTemperature(adc1_raw_val);
+
+        // 3. Konverzija u OBICNI Integer (cijeli stepeni)
+        // Ovo pretvara 33.80 (3380) u 33. To je ono sto zelis.
+        temp_int_for_vp = calculated_temp / 100;
+
+        // 4. Saljemo na VP_NTC_TEMP (mirror je big-endian, kao DGUS RAM)
+        Vpb_Set(VPB_NTC_TEMP, (u16)temp_int_for_vp);
+
+        // 5. Posalji Debug info na UART5
+        UART5_SendStr("NTC Raw: ", 9);
+        // Ispis sirovog ADC
+        UART5_Sendbyte((adc1_raw_val / 10000) + '0');
+        UART5_Sendbyte(((adc1_raw_val % 10000) / 1000) + '0');
+        UART5_Sendbyte(((adc1_raw_val % 1000) / 100) + '0');
+        UART5_Sendbyte(((adc1_raw_val % 100) / 10) + '0');
+        UART5_Sendbyte((adc1_raw_val % 10) + '0');
+
+        UART5_SendStr(" | Temp: ", 9);
+
+        // Ispis stotinki stepena kao XX.XX
+        if(calculated_temp < 0) {
+            UART5_Sendbyte('-');
+            calculated_temp = -calculated_temp;
+        }
 
-        // Prebaci ID slike: 0 -> 1 -> 0
-        if(current_image_id == 0) current_image_id = 1;
-        else current_image_id = 0;
+        // Cijeli dio
+        UART5_Sendbyte(((u16)calculated_temp / 1000) % 10 + '0');
+        UART5_Sendbyte(((u16)calculated_temp / 100) % 10 + '0');
+        UART5_Sendbyte('.');
+        // Decimalni dio
+        UART5_Sendbyte(((u16)calculated_temp / 10) % 10 + '0');
+        UART5_Sendbyte(((u16)calculated_temp % 10) + '0');
 
-        // Poalji komandu za promjenu slike (VP 0x0084)
-        command.enable_mode = 0x5A01;
-        command.pic_id = current_image_id;
-        write_dgus_vp(0x0084, &command, 4);
+        UART5_SendStr(" C\r\n", 4);
     }
-
-    // --- 2. Logika za ikonice (Samo ako je slika 00 aktivna) ---
-    if(current_image_id == 0)
+    else
     {
-        // A) iconDND na VP 0x1030 (Svakih 400ms)
-        if((u16)(Wait_Count - last_dnd_time) >= 400)
-        {
-            last_dnd_time = Wait_Count;
+        UART5_SendStr("ADC Error\r\n", 11);
+    }
+}
 
-            // Toggle vrijednost 0 <-> 1
-            if(val_dnd == 0) val_dnd = 1;
-            else val_dnd = 0;
+// --- Task: Button Handling (Svakih 20ms) ---
+static void Task_Button_Poll(void)
+{
+    // The display is expected to write '1' to VP_BUTTON when the button is pressed.
+    // Check and clear with one address setup. Not atomic: a second press the GUI
+    // core writes between the read and the clear (a few SFR accesses) is lost.
+    if(cas_dgus_vp(VP_BUTTON, 1, 0))
+    {
+        my_variable++; // Increment the counter
 
-            // Upis na VP 0x1030 (DND Icon)
-            write_dgus_vp(0x1030, &val_dnd, 2);
-        }
+        // Send debug information via UART
+        UART5_SendStr("Variable updated [new value:", 28);
 
-        // B) iconHMD na VP 0x1040 (Svakih 900ms)
-        if((u16)(Wait_Count - last_hmd_time) >= 900)
-        {
-            last_hmd_time = Wait_Count;
+        // Convert the 3-digit counter value to ASCII and send character by character
+        UART5_Sendbyte(((my_variable / 100) % 10) + '0'); // Hundreds digit
+        UART5_Sendbyte(((my_variable / 10) % 10) + '0');  // Tens digit
+        UART5_Sendbyte((my_variable % 10) + '0');         // Units digit
+        UART5_SendStr("]\r\n", 3); // End of line
+    }
+}
 
-            // Toggle vrijednost 0 <-> 1
-            if(val_hmd == 0) val_hmd = 1;
-            else val_hmd = 0;
+// --- Touch dogadjaji (touch.h), Touch_Poll se zove svakih TOUCH_POLL_MS ---
+void Touch_Event(u8 zone, u8 event)
+{
+    // SKRIVENI MENI: Long Press 5s u gornjem lijevom kutu (60x60 piksela)
+    if(zone == ZONE_HIDDEN_MENU && event == TOUCH_EV_LONG)
+    {
+        // VP_HIDDEN_MENU je shared: GUI ga moze sam vratiti, upis ide uvijek
+        Vpb_Set(VPB_HIDDEN_MENU, 1);
 
-            // Upis na VP 0x1040 (HMD Icon)
-            write_dgus_vp(0x1040, &val_hmd, 2);
-        }
+        UART5_SendStr("Hidden Menu Triggered!\r\n", 24);
     }
 }
+
 /**
  * @brief Main Entry Point
  * @details Initializes system peripherals and enters the infinite control loop.
+ *          Periodic work runs as scheduler tasks (sched.h); a pass with nothing
+ *          due touches no DGUS RAM.
  */
 void main(void)
 {
+    u8 task;
+    pt flash_pt;    // Test_Flash_Write_Full_16ICL (sys.c)
+
     // --- Initialization Phase ---
     INIT_CPU();     // Initialize CPU core registers and GPIO directions
-    T0_Init();      // Initialize Timer 0 (System Tick)
-    T1_Init();      // Initialize Timer 1 (RTC Tick)
-    T2_Init();      // Initialize Timer 2 (1kHz PWM on P2.0)
+    T2_Init();      // Initialize Timer 2 (System Tick, RTC)
     UART5_Init();   // Initialize UART5 for communication
     RTC_Init();     // Initialize Real Time Clock
     PORT_Init();    // Initialize Port IO specific configurations
+    DGUS_Shadow_Init(); // Mark the VP shadow RAM unknown
+    Vpb_Init();         // Load the VP binding mirror (vp_bind.h)
+    ADC_Sampler_Init(); // Reset ADC oversampling/filter state
 
     // Send startup message
     UART5_SendStr("Demo Started\r\n", 14);
@@ -251,102 +319,70 @@ void main(void)
     // Update real RTC reg.
     Update_GUI_RTC();
 
-    // Initialize the keep-alive timer
-    last_keep_alive = Wait_Count;
-    last_p1_update = Wait_Count;
+    // Hardware PWM0: 1kHz, 50% (bivsi Timer 2 bit-bang na P2.0)
+    PWM_Set(0, 1000, 500);
+
+    // Touch hot zones (id, x0, y0, x1, y1, long press ms)
+    Touch_Add_Zone(ZONE_HIDDEN_MENU, 0, 0, 60, 60, 5000);
+
+    // Register periodic tasks (id, period ms, first run offset ms, priority)
+    Sched_Add(TASK_ADC,      ADC_SAMPLE_MS, 0, 0);
+    Sched_Add(TASK_BUTTON,   20,   0,    0);
+    Sched_Add(TASK_TOUCH,    TOUCH_POLL_MS, 10, 0);
+    Sched_Add(TASK_P1,       100,  0,    1);
+    Sched_Add(TASK_ICON_DND, 400,  0,    1);
+    Sched_Add(TASK_ICON_HMD, 900,  0,    1);
+    Sched_Add(TASK_IMAGE,    5000, 5000, 2);
+    Sched_Add(TASK_NTC,      2000, 2000, 3);
+    PT_INIT(&flash_pt);
 
     // --- Main Control Loop ---
     while(1)
     {
+        // Loop pass time (prof.h)
+        PROF_LOOP_MARK();
+
         // Update RTC and synchronize with Display VP if needed
         Time_Update();
 
-        // Try switching two background image
-        Test_Image_Switch();
-
-
         //Self_Destruct_Test();
-        // --- P1 Update (100ms) ---
-        if((u16)(Wait_Count - last_p1_update) >= 100)
-        {
-            last_p1_update = Wait_Count;
-            P1 = p1_cnt++;
-            LED_Set_Brightness_Now(p1_cnt/3);
-
-        }
+        //Test_Flash_Write_Full_16ICL(&flash_pt);
 
-        // --- Glavna petlja (Keep Alive + NTC mjerenje) ---
-        if((u16)(Wait_Count - last_keep_alive) >= 2000) // Svake 2 sekunde
+        // --- Scheduled Tasks (one per pass, most urgent first) ---
+        task = Sched_Next();
+        if(task != SCHED_IDLE)
         {
-            last_keep_alive = Wait_Count;
-
-            // 1. Procitaj ADC (Kanal 1 - gdje je NTC spojen)
-            if(ADC_Read_Raw(1, &adc1_raw_val) == 0)
+            switch(task)
             {
-                u8 temp_buffer[2];
-
-                // 2. Izracunaj temperaturu
-                calculated_temp = ROOM_GetTemperature(adc1_raw_val);
-
-                // 3. Konverzija u OBICNI Integer (BEZ MNOZENJA SA 100)
-                // Ovo pretvara 33.80 u 33. To je ono sto zelis.
-                temp_int_for_vp = (s16)calculated_temp;
-
-                // 4. Rucno pakovanje (High/Low byte)
-                temp_buffer[0] = (u8)((temp_int_for_vp >> 8) & 0xFF);
-                temp_buffer[1] = (u8)(temp_int_for_vp & 0xFF);
-
-                // Saljemo na VP 0x1020
-                write_dgus_vp(0x1020, temp_buffer, 2);
-
-                // 5. Posalji Debug info na UART5
-                UART5_SendStr("NTC Raw: ", 9);
-                // Ispis sirovog ADC
-                UART5_Sendbyte((adc1_raw_val / 10000) + '0');
-                UART5_Sendbyte(((adc1_raw_val % 10000) / 1000) + '0');
-                UART5_Sendbyte(((adc1_raw_val % 1000) / 100) + '0');
-                UART5_Sendbyte(((adc1_raw_val % 100) / 10) + '0');
-                UART5_Sendbyte((adc1_raw_val % 10) + '0');
-
-                UART5_SendStr(" | Temp: ", 9);
-
-                // Jednostavan ispis float-a (XX.XX)
-                if(calculated_temp < 0) {
-                    UART5_Sendbyte('-');
-                    calculated_temp = -calculated_temp;
-                }
-
-                // Cijeli dio
-                UART5_Sendbyte(((u16)calculated_temp / 10) + '0');
-                UART5_Sendbyte(((u16)calculated_temp % 10) + '0');
-                UART5_Sendbyte('.');
-                // Decimalni dio
-                UART5_Sendbyte((((u16)(calculated_temp * 100)) % 100) / 10 + '0');
-                UART5_Sendbyte((((u16)(calculated_temp * 100)) % 10) + '0');
-
-                UART5_SendStr(" C\r\n", 4);
-            }
-            else
-            {
-                UART5_SendStr("ADC Error\r\n", 11);
+            case TASK_BUTTON:   Task_Button_Poll(); break;
+            case TASK_TOUCH:    Touch_Poll();       break;
+            case TASK_P1:       Task_P1_Update();   break;
+            case TASK_ICON_DND: Test_Icon_DND();    break;
+            case TASK_ICON_HMD: Test_Icon_HMD();    break;
+            case TASK_IMAGE:    Test_Image_Switch(); break;
+            case TASK_NTC:      Task_NTC_Report();  break;
+            case TASK_ADC:      ADC_Sampler_Tick(); break;
             }
+            Sched_Done(task);
         }
 
         // --- UART RX Handling ---
-        // Check if there is new data in the UART receive buffer
-        if(Rx_Head != Rx_Tail)
+        // Drain the UART receive buffer; framed binary traffic (5A A5 ...) goes to
+        // the protocol parser, everything else to the ASCII digit commands.
+        while(Rx_Head != Rx_Tail)
         {
             // Read one byte from the circular buffer
             u8 c = Rx_Buffer[Rx_Tail];
-            Rx_Tail = (Rx_Tail + 1) & 0x1F; // Increment tail with wrap-around
+            Rx_Tail = (Rx_Tail + 1) & (UART5_RX_SIZE - 1); // Increment tail with wrap-around
+
+            if(Proto_Feed(c)) continue;
 
             // Process Numeric Commands
             // Check if the received character is a digit '0'-'9'
             if(c >= '0' && c <= '9')
             {
-                u16 val = (u16)(c - '0'); // Convert ASCII to integer
-                // Write the value to DGUS Variable Pointer (VP) address 0x1100
-                write_dgus_vp(0x2040, &val, 2);
+                // Convert ASCII to integer and write it to VP_UART_DIGIT
+                Vpb_Set(VPB_UART_DIGIT, (u16)(c - '0'));
 
                 // Echo back valid input
                 UART5_SendStr("written number: ", 16);
@@ -360,66 +396,20 @@ void main(void)
             }
         }
 
-        // --- Button Handling ---
-        // Read the status of the button at VP address 0x1200.
-        // The display is expected to write '1' to this address when the button is pressed.
-        read_dgus_vp(0x1200, &button_val, 2);
+        // --- Page Switch Confirmation (VP_PIC_NOW) ---
+        Page_Poll();
 
-        if(button_val == 1)
-        {
-            my_variable++; // Increment the counter
-
-            // Send debug information via UART
-            UART5_SendStr("Variable updated [new value:", 28);
-
-            // Convert the 3-digit counter value to ASCII and send character by character
-            UART5_Sendbyte(((my_variable / 100) % 10) + '0'); // Hundreds digit
-            UART5_Sendbyte(((my_variable / 10) % 10) + '0');  // Tens digit
-            UART5_Sendbyte((my_variable % 10) + '0');         // Units digit
-            UART5_SendStr("]\r\n", 3); // End of line
-            button_val = 0;
-            write_dgus_vp(0x1200, &button_val, 2);
-        }
+        // --- UART Update Session (verify/apply steps) ---
+        Update_Poll();
 
-        // H) SKRIVENI MENI LOGIKA (Long Press 5s u gornjem lijevom kutu)
-        // ---------------------------------------------------------------
-        read_dgus_vp(0x0016, tp_dump, 7); // Citanje koordinata dodira
+        // --- Flash Block Writes (cheap when idle) ---
+        Flash_Poll();
 
-        status = tp_dump[1];                     
-        x_pos = (tp_dump[2] << 8) | tp_dump[3];  
-        y_pos = (tp_dump[4] << 8) | tp_dump[5];  
-
-        // Provjera: Pritisak aktivan (0x03) i koordinate unutar 60x60 piksela
-        if (status == 0x03 && x_pos <= 60 && y_pos <= 60) 
-        {
-            if (mjerenje_aktivno == 0) {
-                start_vrijeme = Wait_Count; // **ISPRAVLJENO: Koristimo Wait_Count umjesto HAL_GetTick**
-                mjerenje_aktivno = 1;          
-                okinuto = 0;                   
-            }
-            
-            if (mjerenje_aktivno == 1 && okinuto == 0) {
-                // Provjera 5000ms
-                if ((u16)(Wait_Count - start_vrijeme) >= 5000) {
-                    
-                    // --- AKCIJA NAKON 5 SEKUNDI ---
-                    u16 trigger_val = 1; 
-                    // **ISPRAVLJENO: Slanje pointera &trigger_val, ne konstante**
-                    write_dgus_vp(0x1050, &trigger_val, 2); 
-                    
-                    UART5_SendStr("Hidden Menu Triggered!\r\n", 24);
-                    
-                    okinuto = 1; // Sprijeci ponavljanje
-                }
-            }
-        } 
-        else {
-            // Reset ako se pusti prst ili izade iz zone
-            mjerenje_aktivno = 0;
-            start_vrijeme = 0;
-            okinuto = 0;
-        }
-        
+        // --- DGUS Burst Flush ---
+        // Changed bound VPs join the queue, then all VP writes queued during
+        // this pass go out in one EA-off window
+        Vpb_Sync();
+        flush_dgus_vp();
     }
 }
-//*******************************************************************//
\ No newline at end of file
+//*******************************************************************//
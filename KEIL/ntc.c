@@ -0,0 +1,40 @@
+/**
+ * @file ntc.c
+ * @brief NTC Thermistor Conversion.
+ * @details Table-driven replacement for the float Beta-equation evaluation
+ *          (log() and two float divisions per reading). Entry i of ntc_table holds
+ *          the temperature at ADC code i << NTC_TABLE_SHIFT; the low bits
+ *          interpolate linearly between two entries. Interpolation error against
+ *          the float reference is below 0.1 C from -20 C to 100 C (printed by
+ *          TOOLS/ntc_table.py when the table is generated).
+ */
+
+#include "ntc.h"
+#include "ntc_table.h"
+
+/**
+ * @brief Convert a raw NTC ADC value to temperature.
+ * @details Keeps the guards of the float version: full scale means the sensor is
+ *          open, zero means it is shorted.
+ * @param adc_value 16-bit ADC value
+ * @return Temperature in 0.01 C
+ */
+s16 NTC_GetTemperature(u16 adc_value)
+{
+    u8 i;
+    s16 a;
+    s16 t;
+    s32 d;
+
+    if(adc_value >= 65534) return NTC_OPEN;
+    if(adc_value == 0) return NTC_SHORT;
+
+    i = (u8)(adc_value >> NTC_TABLE_SHIFT);
+    a = ntc_table[i];
+    d = (s32)(ntc_table[i + 1] - a) * (adc_value & ((1 << NTC_TABLE_SHIFT) - 1));
+    t = a + (s16)(d >> NTC_TABLE_SHIFT);
+
+    if(t < NTC_OPEN) return NTC_OPEN;
+    if(t > NTC_SHORT) return NTC_SHORT;
+    return t;
+}
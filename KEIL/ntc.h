@@ -0,0 +1,32 @@
+/**
+ * @file ntc.h
+ * @brief NTC Thermistor Conversion Header File.
+ * @details Converts a 16-bit T5L ADC reading of the NTC divider (DWIN_GUI_VP.h:
+ *          AMBIENT_NTC_*) to temperature without floating point. The Beta equation
+ *          is evaluated offline by TOOLS/ntc_table.py into ntc_table.h; at run time
+ *          one table lookup and a linear interpolation remain.
+ */
+
+#ifndef __NTC_H__
+#define __NTC_H__
+
+#include "sys.h"
+
+// --- Configuration ---
+#define NTC_TABLE_SHIFT     9                               /**< ADC bits below the table index */
+#define NTC_TABLE_SIZE      ((65536UL >> NTC_TABLE_SHIFT) + 1)  /**< Segment boundaries */
+
+// --- Error Results (centi-degrees) ---
+#define NTC_OPEN            (-9999)     /**< Sensor open (ADC at full scale), -99.99 C */
+#define NTC_SHORT           9999        /**< Sensor shorted (ADC 0), 99.99 C */
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Convert a raw NTC ADC value to temperature
+ * @param adc_value 16-bit ADC value (VP_ADC_INSTANT word)
+ * @return Temperature in 0.01 C, clamped to NTC_OPEN..NTC_SHORT
+ */
+s16 NTC_GetTemperature(u16 adc_value);
+
+#endif
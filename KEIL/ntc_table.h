@@ -0,0 +1,32 @@
+/**
+ * @file ntc_table.h
+ * @brief NTC ADC -> centi-degree table, generated by TOOLS/ntc_table.py.
+ * @details Do not edit. RREF 10000, B 3977, PULLUP 10000; entry i is the temperature
+ *          at ADC code (i << NTC_TABLE_SHIFT). Included by ntc.c only.
+ */
+
+#ifndef __NTC_TABLE_H__
+#define __NTC_TABLE_H__
+
+static code s16 ntc_table[NTC_TABLE_SIZE] =
+{
+     32000,  19502,  15933,  14072,  12837,  11921,  11197,  10601,
+     10095,   9656,   9269,   8923,   8610,   8325,   8062,   7819,
+      7592,   7380,   7181,   6993,   6815,   6646,   6484,   6330,
+      6182,   6040,   5904,   5772,   5645,   5523,   5404,   5288,
+      5176,   5067,   4961,   4857,   4756,   4657,   4560,   4466,
+      4373,   4282,   4193,   4105,   4019,   3934,   3851,   3768,
+      3687,   3607,   3528,   3450,   3373,   3297,   3221,   3147,
+      3072,   2999,   2926,   2854,   2782,   2711,   2640,   2570,
+      2500,   2430,   2361,   2292,   2223,   2154,   2085,   2017,
+      1949,   1880,   1812,   1744,   1675,   1607,   1538,   1469,
+      1400,   1331,   1261,   1192,   1121,   1051,    980,    908,
+       836,    763,    690,    615,    541,    465,    388,    310,
+       231,    151,     70,    -13,    -98,   -184,   -271,   -361,
+      -453,   -547,   -644,   -744,   -847,   -953,  -1063,  -1177,
+     -1296,  -1420,  -1551,  -1688,  -1834,  -1989,  -2156,  -2335,
+     -2532,  -2749,  -2993,  -3273,  -3605,  -4016,  -4567,  -5445,
+    -10560
+};
+
+#endif
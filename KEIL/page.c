@@ -0,0 +1,83 @@
+/**
+ * @file page.c
+ * @brief Page Switch Manager.
+ * @details The VP_PIC_SET command is built byte by byte (big-endian, as the GUI
+ *          core reads it) and written directly after the flush, so it is the
+ *          last DGUS write of the switch.
+ */
+
+#include "page.h"
+#include "dgus.h"
+#include "prof.h"
+#include "sched.h"
+#include "DWIN_GUI_VP.h"
+
+u16 Page_Now = 0;
+u16 Page_Errors = 0;
+
+static u16 page_target;
+static u8 page_state;       // 0 idle, 1 preparing, 2 waiting for VP_PIC_NOW
+static u32 page_start;      // Sched_Stamp() of the commit
+static u16 page_start_ms;   // Wait_Count of the commit (timeout)
+static u16 page_poll_last;  // Wait_Count of the last VP_PIC_NOW read
+
+u8 Page_Begin(u16 pic)
+{
+    if(page_state == 2) return 1;
+    page_target = pic;
+    page_state = 1;
+    return 0;
+}
+
+void Page_Commit(void)
+{
+    u8 cmd[4];
+
+    if(page_state != 1) return;
+
+    // --- 1. Page values: one burst ---
+    flush_dgus_vp();
+
+    // --- 2. Switch: 0x5A01 + page id ---
+    cmd[0] = 0x5A;
+    cmd[1] = 0x01;
+    cmd[2] = (u8)(page_target >> 8);
+    cmd[3] = (u8)page_target;
+    write_dgus_vp(VP_PIC_SET, cmd, 4);
+
+    page_start = Sched_Stamp();
+    page_start_ms = Wait_Count;
+    page_poll_last = Wait_Count;
+    page_state = 2;
+}
+
+void Page_Poll(void)
+{
+    u16 now;
+    u32 dt;
+
+    if(page_state != 2) return;
+    if((u16)(Wait_Count - page_poll_last) < PAGE_POLL_MS) return;
+    page_poll_last = Wait_Count;
+
+    DGUS_READ_U16(VP_PIC_NOW, now);
+    if(now == page_target)
+    {
+        dt = Sched_Stamp();
+        if(dt < page_start) dt += 65536UL * SCHED_TICKS_PER_MS; // Wait_Count wrapped
+        Prof_Sample(PROF_PAGE_SWITCH, dt - page_start);
+        Page_Now = page_target;
+        page_state = 0;
+    }
+    else if((u16)(Wait_Count - page_start_ms) >= PAGE_TIMEOUT_MS)
+    {
+        Page_Errors++;
+        Page_Now = now;
+        page_state = 0;
+    }
+}
+
+u8 Page_Pending(void)
+{
+    return page_state == 2;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file page.h
+ * @brief Page Switch Manager Header File.
+ * @details Switches the displayed page only after its VP values are in DGUS RAM:
+ *
+ *          Page_Begin(id);             target page
+ *          Vpb_Set(VPB_x, val);        any number of values for that page
+ *          Vpb_Sync();                 (or queue_dgus_vp() for unbound VPs)
+ *          Page_Commit();              one burst, then VP_PIC_SET
+ *
+ *          The values go through the write-combining queue (dgus.h), so the GUI
+ *          core never renders the new page with the previous page's values.
+ *          Page_Poll() reads VP_PIC_NOW back every PAGE_POLL_MS until the GUI core
+ *          reports the new page; the commit-to-confirm time is recorded as prof.h site
+ *          PROF_PAGE_SWITCH, a missing confirmation as Page_Errors.
+ */
+
+#ifndef __PAGE_H__
+#define __PAGE_H__
+
+#include "sys.h"
+
+// --- Configuration ---
+#define PAGE_POLL_MS        1       /**< VP_PIC_NOW read interval while a switch is pending */
+#define PAGE_TIMEOUT_MS     500     /**< VP_PIC_NOW must follow within this time */
+
+// --- Global External Variables ---
+/** @brief Page confirmed by VP_PIC_NOW (the previous one while a switch is pending). */
+extern u16 Page_Now;
+/** @brief Switches that were not confirmed within PAGE_TIMEOUT_MS. */
+extern u16 Page_Errors;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Start preparing a page switch
+ * @param pic Target page id
+ * @return 0 OK, 1 a previous switch is still waiting for confirmation
+ */
+u8 Page_Begin(u16 pic);
+
+/**
+ * @brief Flush the prepared values in one burst, then switch the page
+ */
+void Page_Commit(void);
+
+/**
+ * @brief Confirm a pending switch through VP_PIC_NOW (main loop; idle = no access)
+ */
+void Page_Poll(void);
+
+/**
+ * @brief Switch state
+ * @return 1 while a committed switch is not yet confirmed
+ */
+u8 Page_Pending(void);
+
+#endif
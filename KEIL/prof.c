@@ -0,0 +1,109 @@
+/**
+ * @file prof.c
+ * @brief Run-Time Instrumentation.
+ * @details Probes cost one carry-safe Timer 2 read each. An EA-off window is the
+ *          counter difference; when the counter auto-reloaded in between (end below
+ *          start) the jump from 0xFFFF to TICK_RELOAD is taken out again. Windows
+ *          are assumed shorter than one tick. Only the two stamps fall inside the
+ *          window; the statistics are updated after EA = 1.
+ */
+
+#include "prof.h"
+#include "sched.h"
+
+prof_stat Prof_Stats[PROF_SITES];
+u16 data prof_ea_start;
+u16 data prof_ea_stop;
+
+/** @brief Sched_Stamp() at the previous loop mark, 0 = none yet. */
+static u32 prof_loop_last = 0;
+
+/**
+ * @brief Add one sample to a site.
+ */
+static void prof_add(u8 site, u32 dt)
+{
+    prof_stat* s = &Prof_Stats[site];
+
+    if(s->total + dt < s->total)
+    {
+        s->total >>= 1;
+        s->count >>= 1;
+    }
+    s->total += dt;
+    s->count++;
+    if(dt > s->max) s->max = dt;
+}
+
+/**
+ * @brief Raw Timer 2 counter, carry-safe.
+ * @details TH2 is read again after TL2 to catch a TL2 overflow in between.
+ */
+u16 Prof_Counter(void)
+{
+    u8 th, tl;
+
+    th = TH2;
+    tl = TL2;
+    if(th != TH2) { th = TH2; tl = TL2; }
+    return ((u16)th << 8) | tl;
+}
+
+/**
+ * @brief Account the EA-off window between PROF_EA_BEGIN() and PROF_EA_STAMP().
+ * @details Runs with EA = 1. The stamps and the statistics are only touched by
+ *          main-loop code (no ISR opens a probed window), so no locking is needed.
+ * @param site PROF_DGUS_* site
+ */
+void Prof_EA_End(u8 site)
+{
+    u16 dt = prof_ea_stop - prof_ea_start;
+
+    if(prof_ea_stop < prof_ea_start) dt -= TICK_RELOAD; // Reloaded during the window
+
+    prof_add(site, dt);
+    prof_add(PROF_EA_OFF, dt);
+}
+
+/**
+ * @brief Add one measured duration to a site.
+ * @param site PROF_* site
+ * @param dt Duration in Timer 2 counts
+ */
+void Prof_Sample(u8 site, u32 dt)
+{
+    prof_add(site, dt);
+}
+
+/**
+ * @brief Account the time since the previous call as one loop pass.
+ */
+void Prof_Loop(void)
+{
+    u32 now = Sched_Stamp();
+    u32 dt;
+
+    if(prof_loop_last != 0)
+    {
+        dt = now - prof_loop_last;
+        if(now < prof_loop_last) dt += 65536UL * SCHED_TICKS_PER_MS; // Wait_Count wrapped
+        prof_add(PROF_LOOP, dt);
+    }
+    prof_loop_last = now;
+}
+
+/**
+ * @brief Clear all statistics.
+ */
+void Prof_Reset(void)
+{
+    u8 i;
+
+    for(i = 0; i < PROF_SITES; i++)
+    {
+        Prof_Stats[i].count = 0;
+        Prof_Stats[i].max = 0;
+        Prof_Stats[i].total = 0;
+    }
+    prof_loop_last = 0;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file prof.h
+ * @brief Run-Time Instrumentation Header File.
+ * @details Records main-loop pass time and every interrupt-disabled DGUS access
+ *          window. Stamps come from the Timer 2 tick counter (FOSC/12, ~58 ns per
+ *          count): EA-off windows read the raw 16-bit counter, which keeps running
+ *          (and auto-reloads) while interrupts are off; the loop time uses
+ *          Sched_Stamp(), which also counts the ticks in between. Longer operations
+ *          measured elsewhere (page switches) are added with Prof_Sample().
+ *
+ *          The statistics are sent over UART5 with the PROTO_CMD_PROF frame
+ *          (proto.h) and printed by the host simulator at the end of a run.
+ *          Set PROF_ENABLE to 0 to compile all probes out.
+ */
+
+#ifndef __PROF_H__
+#define __PROF_H__
+
+#include "sys.h"
+
+// --- Configuration ---
+#define PROF_ENABLE         1   /**< 0 = probes compile to nothing */
+
+// --- Probe Sites ---
+#define PROF_LOOP           0   /**< One pass of the main loop */
+#define PROF_EA_OFF         1   /**< Any EA-off window below (combined) */
+#define PROF_DGUS_READ      2   /**< read_dgus_vp() EA-off window */
+#define PROF_DGUS_WRITE     3   /**< write_dgus_vp() EA-off window */
+#define PROF_DGUS_FLUSH     4   /**< flush_dgus_vp() EA-off window */
+#define PROF_PAGE_SWITCH    5   /**< Page_Commit() until VP_PIC_NOW confirms (page.h) */
+#define PROF_DGUS_RMW       6   /**< modify_dgus_vp() / cas_dgus_vp() EA-off window */
+#define PROF_SITES          7
+
+// --- Structures ---
+/**
+ * @brief Statistics of one probe site, times in Timer 2 counts
+ * @details Average = total / count. When total would overflow both are halved,
+ *          so the average stays valid over any uptime.
+ */
+typedef struct _prof_stat
+{
+    u32 count;      // Number of samples
+    u32 max;        // Longest sample
+    u32 total;      // Sum of samples
+} prof_stat;
+
+// --- Global External Variables ---
+extern prof_stat Prof_Stats[PROF_SITES];
+extern u16 data prof_ea_start;
+extern u16 data prof_ea_stop;
+
+// --- Probe Macros ---
+#if PROF_ENABLE
+/** @brief Call right after EA = 0. */
+#define PROF_EA_BEGIN()     (prof_ea_start = Prof_Counter())
+/** @brief Call right before EA = 1: only the end stamp is taken inside the window. */
+#define PROF_EA_STAMP()     (prof_ea_stop = Prof_Counter())
+/** @brief Call right after EA = 1: accounts the window outside of it. */
+#define PROF_EA_END(site)   Prof_EA_End(site)
+/** @brief Call once at the top of every main-loop pass. */
+#define PROF_LOOP_MARK()    Prof_Loop()
+#else
+#define PROF_EA_BEGIN()
+#define PROF_EA_STAMP()
+#define PROF_EA_END(site)
+#define PROF_LOOP_MARK()
+#endif
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Raw Timer 2 counter, carry-safe
+ */
+u16 Prof_Counter(void);
+
+/**
+ * @brief Account the EA-off window between PROF_EA_BEGIN() and PROF_EA_STAMP()
+ * @param site PROF_DGUS_* site
+ */
+void Prof_EA_End(u8 site);
+
+/**
+ * @brief Add one measured duration to a site
+ * @param site PROF_* site
+ * @param dt Duration in Timer 2 counts
+ */
+void Prof_Sample(u8 site, u32 dt);
+
+/**
+ * @brief Account the time since the previous call as one loop pass
+ */
+void Prof_Loop(void);
+
+/**
+ * @brief Clear all statistics
+ */
+void Prof_Reset(void);
+
+#endif
@@ -0,0 +1,266 @@
+/**
+ * @file proto.c
+ * @brief UART5 Framed Binary Protocol.
+ * @details Byte-wise state machine fed from the UART5 receive ring by the main
+ *          loop. A complete, CRC-checked frame is executed at once: a write frame
+ *          becomes one write_dgus_vp() call (one EA-off burst), a read frame one
+ *          read_dgus_vp() call, so a host can push or fetch a whole screen state
+ *          in a single round trip.
+ */
+
+#include "proto.h"
+#include "uart.h"
+#include "prof.h"
+#include "update.h"
+
+/** @brief Parser states. */
+#define ST_HEAD_H   0
+#define ST_HEAD_L   1
+#define ST_LEN      2
+#define ST_BODY     3
+
+/** @brief CRC16 nibble table (poly 0xA001), 32 bytes of code instead of 512. */
+static const u16 code crc16_nibble[16] = {
+    0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
+    0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400
+};
+
+static u8 proto_state = ST_HEAD_H;
+static u8 proto_len;
+static u8 proto_pos;
+static u16 proto_last;
+/** @brief Frame body (CMD, payload, CRC) and response buffer. */
+static u8 proto_buf[PROTO_MAX_LEN + 3];
+
+/**
+ * @brief Calculate CRC16 (Modbus).
+ * @param buf Data pointer
+ * @param len Number of bytes
+ * @return CRC value
+ */
+u16 Proto_CRC16(u8* buf, u16 len)
+{
+    return Proto_CRC16_Add(0xFFFF, buf, len);
+}
+
+/**
+ * @brief Continue a CRC16 (Modbus) over more data.
+ * @param crc CRC of the data so far (0xFFFF to start)
+ * @param buf Data pointer
+ * @param len Number of bytes
+ * @return CRC value
+ */
+u16 Proto_CRC16_Add(u16 crc, u8* buf, u16 len)
+{
+    while(len--)
+    {
+        crc ^= *buf++;
+        crc = (crc >> 4) ^ crc16_nibble[crc & 0x0F];
+        crc = (crc >> 4) ^ crc16_nibble[crc & 0x0F];
+    }
+    return crc;
+}
+
+/**
+ * @brief Send a frame whose CMD and payload are in proto_buf.
+ * @param n Number of CMD + payload bytes
+ */
+static void proto_reply(u8 n)
+{
+    u8 head[3];
+    u16 crc = Proto_CRC16(proto_buf, n);
+
+    proto_buf[n] = (u8)crc;
+    proto_buf[n + 1] = (u8)(crc >> 8);
+
+    head[0] = PROTO_HEAD_H;
+    head[1] = PROTO_HEAD_L;
+    head[2] = n + 2;
+    UART5_SendStr(head, 3);
+    UART5_SendStr(proto_buf, n + 2);
+}
+
+/**
+ * @brief Answer CMD 'O' 'K' (ok != 0) or CMD 'E' 'R'.
+ */
+static void proto_ack(u8 ok)
+{
+    proto_buf[1] = ok ? 'O' : 'E';
+    proto_buf[2] = ok ? 'K' : 'R';
+    proto_reply(3);
+}
+
+/**
+ * @brief Store a u32 big-endian in proto_buf.
+ */
+static void proto_put32(u8 pos, u32 v)
+{
+    proto_buf[pos] = (u8)(v >> 24);
+    proto_buf[pos + 1] = (u8)(v >> 16);
+    proto_buf[pos + 2] = (u8)(v >> 8);
+    proto_buf[pos + 3] = (u8)v;
+}
+
+/**
+ * @brief Answer an update command with OK STATE ERROR NEXT_H NEXT_L.
+ */
+static void proto_update_reply(u8 refused)
+{
+    proto_buf[1] = !refused;
+    proto_buf[2] = Update_Status.state;
+    proto_buf[3] = Update_Status.error;
+    proto_buf[4] = (u8)(Update_Status.next >> 8);
+    proto_buf[5] = (u8)Update_Status.next;
+    proto_reply(6);
+}
+
+/**
+ * @brief Execute the frame in proto_buf (n = CMD + payload bytes, CRC already checked).
+ */
+static void proto_execute(u8 n)
+{
+    u16 i;
+    u8 words;
+    u16 vp;
+
+    switch(proto_buf[0])
+    {
+    case PROTO_CMD_WRITE:
+        // VP_H VP_L data..., data must be whole words
+        if(n < 5 || ((n - 3) & 0x01)) { proto_ack(0); break; }
+        vp = ((u16)proto_buf[1] << 8) | proto_buf[2];
+        write_dgus_vp(vp, &proto_buf[3], n - 3);
+        proto_ack(1);
+        break;
+
+    case PROTO_CMD_READ:
+        // VP_H VP_L WORDS -> echo header + data
+        words = proto_buf[3];
+        if(n != 4 || words == 0 || 4 + 2 * (u16)words + 2 > PROTO_MAX_LEN) { proto_ack(0); break; }
+        vp = ((u16)proto_buf[1] << 8) | proto_buf[2];
+        read_dgus_vp(vp, &proto_buf[4], (u16)words * 2);
+        proto_reply(4 + words * 2);
+        break;
+
+    case PROTO_CMD_BATCH:
+        // Validate all records first, then write: a bad frame writes nothing
+        for(i = 1; i + 3 <= n; i += 3 + 2 * proto_buf[i + 2]);
+        if(n < 4 || i != n) { proto_ack(0); break; }
+        for(i = 1; i < n; i += 3 + 2 * words)
+        {
+            vp = ((u16)proto_buf[i] << 8) | proto_buf[i + 1];
+            words = proto_buf[i + 2];
+            write_dgus_vp(vp, &proto_buf[i + 3], (u16)words * 2);
+        }
+        proto_ack(1);
+        break;
+
+    case PROTO_CMD_PROF:
+        // CLEAR -> SITES, then COUNT MAX TOTAL per site, then RX_OVF
+        if(n != 2 || proto_buf[1] > 1) { proto_ack(0); break; }
+        words = proto_buf[1];
+        proto_buf[1] = PROF_SITES;
+        for(i = 0; i < PROF_SITES; i++)
+        {
+            proto_put32(2 + i * 12, Prof_Stats[i].count);
+            proto_put32(6 + i * 12, Prof_Stats[i].max);
+            proto_put32(10 + i * 12, Prof_Stats[i].total);
+        }
+        EA = 0;
+        proto_buf[2 + PROF_SITES * 12] = (u8)(Rx_Overflow >> 8);
+        proto_buf[3 + PROF_SITES * 12] = (u8)Rx_Overflow;
+        if(words) Rx_Overflow = 0;
+        EA = 1;
+        if(words) Prof_Reset();
+        proto_reply(4 + PROF_SITES * 12);
+        break;
+
+    case PROTO_CMD_UPD_BEGIN:
+        // TARGET SIZE(4) CRC(2) BLOCK(2), delta: { IDX CRC_H CRC_L }*
+        if(n < 10 || (n - 10) % 3) { proto_ack(0); break; }
+        proto_update_reply(Update_Begin(proto_buf[1],
+            ((u32)proto_buf[2] << 24) | ((u32)proto_buf[3] << 16) | ((u16)proto_buf[4] << 8) | proto_buf[5],
+            ((u16)proto_buf[6] << 8) | proto_buf[7],
+            ((u16)proto_buf[8] << 8) | proto_buf[9],
+            &proto_buf[10], (n - 10) / 3));
+        break;
+
+    case PROTO_CMD_UPD_DATA:
+        // OFS_H OFS_L data..., data must be whole words
+        if(n < 5 || ((n - 3) & 0x01)) { proto_ack(0); break; }
+        vp = ((u16)proto_buf[1] << 8) | proto_buf[2];
+        proto_update_reply(Update_Chunk(vp, &proto_buf[3], n - 3));
+        break;
+
+    case PROTO_CMD_UPD_STAT:
+    case PROTO_CMD_UPD_APPLY:
+    case PROTO_CMD_UPD_ABORT:
+        if(n != 1) { proto_ack(0); break; }
+        if(proto_buf[0] == PROTO_CMD_UPD_APPLY) words = Update_Commit();
+        else if(proto_buf[0] == PROTO_CMD_UPD_ABORT) words = Update_Abort();
+        else words = 0;
+        proto_update_reply(words);
+        break;
+
+    default:
+        proto_ack(0);
+        break;
+    }
+}
+
+/**
+ * @brief Feed one received byte into the frame parser.
+ * @details A frame stalled for more than PROTO_TIMEOUT_MS is discarded so a lost
+ *          byte cannot swallow the following traffic. The gap is measured when
+ *          the main loop drains the bytes from the RX ring, not when they arrive:
+ *          a long main-loop pass stretches it, and bytes that waited in the
+ *          ring count as back to back.
+ * @param c Received byte
+ * @return 1 if the byte belongs to a frame, 0 if it should go to the ASCII handler
+ */
+u8 Proto_Feed(u8 c)
+{
+    u16 crc;
+
+    if(proto_state != ST_HEAD_H && (u16)(Wait_Count - proto_last) >= PROTO_TIMEOUT_MS)
+    {
+        proto_state = ST_HEAD_H;
+    }
+    proto_last = Wait_Count;
+
+    switch(proto_state)
+    {
+    case ST_HEAD_H:
+        if(c != PROTO_HEAD_H) return 0;
+        proto_state = ST_HEAD_L;
+        return 1;
+
+    case ST_HEAD_L:
+        if(c == PROTO_HEAD_L) { proto_state = ST_LEN; return 1; }
+        // No frame after all: the byte is parsed again from ST_HEAD_H, it may
+        // start the real frame (5A 5A A5) or be ASCII input
+        if(c == PROTO_HEAD_H) return 1;
+        proto_state = ST_HEAD_H;
+        return 0;
+
+    case ST_LEN:
+        // At least CMD + CRC
+        if(c < 3) { proto_state = ST_HEAD_H; return 1; }
+        proto_len = c;
+        proto_pos = 0;
+        proto_state = ST_BODY;
+        return 1;
+
+    default:
+        proto_buf[proto_pos++] = c;
+        if(proto_pos < proto_len) return 1;
+
+        proto_state = ST_HEAD_H;
+        crc = Proto_CRC16(proto_buf, proto_len - 2);
+        if(proto_buf[proto_len - 2] == (u8)crc && proto_buf[proto_len - 1] == (u8)(crc >> 8))
+        {
+            proto_execute(proto_len - 2);
+        }
+        return 1;
+    }
+}
@@ -0,0 +1,74 @@
+/**
+ * @file proto.h
+ * @brief UART5 Framed Binary Protocol Header File.
+ * @details DGUS-style frames with mandatory CRC16 (Modbus, low byte first):
+ *
+ *          5A A5 | LEN | CMD | payload | CRC_L CRC_H
+ *
+ *          LEN counts CMD, payload and CRC. VP addresses and data are big-endian,
+ *          exactly as stored in DGUS RAM.
+ *          - 0x82 Write:       VP_H VP_L data...             -> 82 'O' 'K'
+ *          - 0x83 Read:        VP_H VP_L WORDS               -> 83 VP_H VP_L WORDS data...
+ *          - 0x8A Batch write: { VP_H VP_L WORDS data... }*  -> 8A 'O' 'K'
+ *          - 0x90 Statistics:  CLEAR                         -> 90 SITES { COUNT MAX TOTAL }* RX_OVF(2)
+ *            (prof.h sites, u32 each, Timer 2 counts; RX_OVF = bytes dropped on a full
+ *            UART5 RX ring; CLEAR = 1 resets after reading)
+ *          - 0xA0 Upd. begin:  TARGET SIZE(4) CRC(2) BLK(2)  -> A0 STATUS
+ *                              [{ IDX CRC_H CRC_L }*] (delta target)
+ *          - 0xA1 Upd. data:   OFS_H OFS_L data...           -> A1 STATUS
+ *          - 0xA2 Upd. status:                               -> A2 STATUS
+ *          - 0xA3 Upd. apply:                                -> A3 STATUS
+ *          - 0xA4 Upd. abort:                                -> A4 STATUS
+ *            (update.h; STATUS = OK STATE ERROR NEXT_H NEXT_L, OFS/NEXT in words,
+ *            low 16 bits, OK = 0 if the request was refused)
+ *          Malformed requests are answered with CMD 'E' 'R'; frames with a bad
+ *          CRC are dropped silently, as the DGUS kernel does.
+ */
+
+#ifndef __PROTO_H__
+#define __PROTO_H__
+
+#include "sys.h"
+
+// --- Frame Constants ---
+#define PROTO_HEAD_H        0x5A    /**< Frame header, first byte */
+#define PROTO_HEAD_L        0xA5    /**< Frame header, second byte */
+#define PROTO_CMD_WRITE     0x82    /**< Write VP range */
+#define PROTO_CMD_READ      0x83    /**< Read VP range */
+#define PROTO_CMD_BATCH     0x8A    /**< Write several VP ranges */
+#define PROTO_CMD_PROF      0x90    /**< Read (and clear) prof.h statistics */
+#define PROTO_CMD_UPD_BEGIN 0xA0    /**< Open/resume an update session */
+#define PROTO_CMD_UPD_DATA  0xA1    /**< Update image chunk */
+#define PROTO_CMD_UPD_STAT  0xA2    /**< Update session status */
+#define PROTO_CMD_UPD_APPLY 0xA3    /**< Verify and apply the image */
+#define PROTO_CMD_UPD_ABORT 0xA4    /**< Drop the update session */
+#define PROTO_MAX_LEN       0xFF    /**< Largest LEN value (CMD + payload + CRC) */
+#define PROTO_TIMEOUT_MS    50      /**< Gap that aborts a partly received frame (as drained by the main loop) */
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Feed one received byte into the frame parser
+ * @param c Received byte
+ * @return 1 if the byte belongs to a frame, 0 if it should go to the ASCII handler
+ */
+u8 Proto_Feed(u8 c);
+
+/**
+ * @brief Calculate CRC16 (Modbus, init 0xFFFF, poly 0xA001)
+ * @param buf Data pointer
+ * @param len Number of bytes
+ * @return CRC value (transmitted low byte first)
+ */
+u16 Proto_CRC16(u8* buf, u16 len);
+
+/**
+ * @brief Continue a CRC16 over more data (Proto_CRC16 = Proto_CRC16_Add(0xFFFF, ...))
+ * @param crc CRC of the data so far
+ * @param buf Data pointer
+ * @param len Number of bytes
+ * @return CRC value
+ */
+u16 Proto_CRC16_Add(u16 crc, u8* buf, u16 len);
+
+#endif
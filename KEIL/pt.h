@@ -0,0 +1,69 @@
+/**
+ * @file pt.h
+ * @brief Protothreads and Deadlines Header File.
+ * @details Stackless cooperative threads for long operations that must not block
+ *          the main loop (flash writes, update sequences). A protothread is a
+ *          function taking a `pt` context; it runs until it has to wait, returns
+ *          PT_WAITING, and resumes at the same line on the next call. The resume
+ *          point is a switch case on __LINE__, so:
+ *          - locals do not survive a wait, keep state in statics or the caller's struct
+ *          - no `switch` statement may enclose a PT_WAIT_* / PT_SLEEP / PT_YIELD
+ *
+ *          Deadlines are absolute Wait_Count values compared with wrap-around
+ *          arithmetic (as in sched.c), usable on their own for polled timeouts.
+ */
+
+#ifndef __PT_H__
+#define __PT_H__
+
+#include "sys.h"
+
+// --- Return Codes ---
+#define PT_WAITING      0   /**< Blocked, call again */
+#define PT_ENDED        1   /**< Ran to PT_END (context is reset for the next run) */
+
+// --- Structures ---
+/**
+ * @brief Protothread Context
+ */
+typedef struct _pt
+{
+    u16 lc;         // Resume point (source line), 0 = start
+    u16 deadline;   // Wait_Count value PT_SLEEP waits for
+} pt;
+
+// --- Deadlines ---
+/** @brief Deadline `ms` from now. */
+#define DEADLINE_IN(ms)         ((u16)(Wait_Count + (ms)))
+/** @brief Nonzero once the deadline has passed (valid for up to 32 s). */
+#define DEADLINE_PASSED(d)      ((s16)((u16)Wait_Count - (u16)(d)) >= 0)
+
+// --- Protothread Macros ---
+#define PT_INIT(p)              ((p)->lc = 0)
+#define PT_BEGIN(p)             switch((p)->lc) { case 0:
+#define PT_END(p)               } (p)->lc = 0; return PT_ENDED
+
+/** @brief Leave the protothread now (next call starts from the top). */
+#define PT_EXIT(p)              do { (p)->lc = 0; return PT_ENDED; } while(0)
+
+/** @brief Return here until cond is true. */
+#define PT_WAIT_UNTIL(p, cond)                                  \
+    do {                                                        \
+        (p)->lc = __LINE__; case __LINE__:                      \
+        if(!(cond)) return PT_WAITING;                          \
+    } while(0)
+
+/** @brief Give the loop one pass, then continue. */
+#define PT_YIELD(p)                                             \
+    do {                                                        \
+        (p)->lc = __LINE__; return PT_WAITING; case __LINE__:;  \
+    } while(0)
+
+/** @brief Non-blocking replacement for delay_ms(ms). */
+#define PT_SLEEP(p, ms)                                         \
+    do {                                                        \
+        (p)->deadline = DEADLINE_IN(ms);                        \
+        PT_WAIT_UNTIL(p, DEADLINE_PASSED((p)->deadline));       \
+    } while(0)
+
+#endif
@@ -0,0 +1,163 @@
+/**
+ * @file sched.c
+ * @brief Cooperative Task Scheduler.
+ * @details Deadlines are absolute Wait_Count values compared with 16-bit
+ *          wrap-around arithmetic, so tasks keep their phase across the 65 s
+ *          tick overflow. The earliest deadline of all tasks is cached in
+ *          sched_next_due; while it has not passed, Sched_Next() returns
+ *          immediately and the main loop does no scheduling work or bus I/O.
+ */
+
+#include "sched.h"
+
+sched_task Sched_Tasks[SCHED_MAX_TASKS];
+
+/** @brief Earliest deadline of all registered tasks. */
+static u16 sched_next_due = 0;
+/** @brief Task currently running and its start stamp. */
+static u8 sched_current = SCHED_IDLE;
+static u32 sched_start;
+
+/** @brief Wrap-safe "deadline has passed" test. */
+#define SCHED_DUE(deadline, now)    ((s16)((u16)(now) - (u16)(deadline)) >= 0)
+
+/**
+ * @brief Recompute the cached earliest deadline.
+ */
+static void sched_update_due(u16 now)
+{
+    u8 i;
+    u16 best = 0xFFFF;  // Distance from now, not an absolute time
+    u16 d;
+
+    for(i = 0; i < SCHED_MAX_TASKS; i++)
+    {
+        if(Sched_Tasks[i].period == 0) continue;
+        d = SCHED_DUE(Sched_Tasks[i].deadline, now) ? 0 : (u16)(Sched_Tasks[i].deadline - now);
+        if(d < best) best = d;
+    }
+    sched_next_due = now + best;
+}
+
+/**
+ * @brief Register a periodic task.
+ * @param id Task number
+ * @param period Period in ms
+ * @param offset Delay of the first run in ms
+ * @param prio Priority, 0 = most urgent
+ */
+void Sched_Add(u8 id, u16 period, u16 offset, u8 prio)
+{
+    sched_task* t;
+    u16 now = Wait_Count;
+
+    if(id >= SCHED_MAX_TASKS || period == 0) return;
+
+    t = &Sched_Tasks[id];
+    t->period = period;
+    t->deadline = now + offset;
+    t->prio = prio;
+    t->runs = 0;
+    t->overruns = 0;
+    t->jitter_max = 0;
+    t->run_max = 0;
+    t->run_total = 0;
+
+    sched_update_due(now);
+}
+
+/**
+ * @brief Pick the most urgent due task.
+ * @details Among due tasks the lowest prio value wins; equal priorities go to
+ *          the task with the oldest deadline.
+ * @return Task number, or SCHED_IDLE
+ */
+u8 Sched_Next(void)
+{
+    u8 i;
+    u8 best = SCHED_IDLE;
+    u16 now = Wait_Count;
+    u16 late, best_late = 0;
+
+    if(!SCHED_DUE(sched_next_due, now)) return SCHED_IDLE;
+
+    for(i = 0; i < SCHED_MAX_TASKS; i++)
+    {
+        if(Sched_Tasks[i].period == 0 || !SCHED_DUE(Sched_Tasks[i].deadline, now)) continue;
+        late = now - Sched_Tasks[i].deadline;
+        if(best == SCHED_IDLE || Sched_Tasks[i].prio < Sched_Tasks[best].prio ||
+           (Sched_Tasks[i].prio == Sched_Tasks[best].prio && late > best_late))
+        {
+            best = i;
+            best_late = late;
+        }
+    }
+
+    if(best != SCHED_IDLE)
+    {
+        if(best_late > Sched_Tasks[best].jitter_max) Sched_Tasks[best].jitter_max = best_late;
+        sched_current = best;
+        sched_start = Sched_Stamp();
+    }
+    return best;
+}
+
+/**
+ * @brief Account a finished run and schedule the next deadline.
+ * @details The next deadline is the previous one plus the period, so start
+ *          jitter does not accumulate into drift. A task that fell more than a
+ *          full period behind is re-phased to now and counted as an overrun.
+ * @param id Task number returned by Sched_Next()
+ */
+void Sched_Done(u8 id)
+{
+    sched_task* t;
+    u32 dt;
+    u16 now;
+
+    if(id >= SCHED_MAX_TASKS) return;
+    t = &Sched_Tasks[id];
+
+    if(id == sched_current)
+    {
+        dt = Sched_Stamp();
+        if(dt < sched_start) dt += 65536UL * SCHED_TICKS_PER_MS; // Wait_Count wrapped
+        dt -= sched_start;
+        t->run_total += dt;
+        if(dt > t->run_max) t->run_max = dt;
+        sched_current = SCHED_IDLE;
+    }
+    t->runs++;
+
+    now = Wait_Count;
+    t->deadline += t->period;
+    if(SCHED_DUE(t->deadline, now))
+    {
+        t->overruns++;
+        t->deadline = now + t->period;
+    }
+    sched_update_due(now);
+}
+
+/**
+ * @brief Free-running time stamp in Timer 2 counts.
+ * @details Timer 2 counts up from TICK_RELOAD and reloads every tick.
+ *          TH2 is read twice to catch a TL2 carry, the tick is re-read to catch
+ *          a reload between the reads.
+ * @return Wait_Count * SCHED_TICKS_PER_MS + counts into the current ms
+ */
+u32 Sched_Stamp(void)
+{
+    u16 ms;
+    u8 th, tl;
+
+    do
+    {
+        ms = Wait_Count;
+        th = TH2;
+        tl = TL2;
+        if(th != TH2) { th = TH2; tl = TL2; }
+    } while(ms != Wait_Count);
+
+    return (u32)ms * SCHED_TICKS_PER_MS + (u16)((((u16)th << 8) | tl) - (u16)TICK_RELOAD);
+}
@@ -0,0 +1,71 @@
+/**
+ * @file sched.h
+ * @brief Cooperative Task Scheduler Header File.
+ * @details Periodic tasks keyed on the 1 ms Wait_Count tick. The main loop asks
+ *          Sched_Next() for the most urgent due task, runs it and reports back with
+ *          Sched_Done(). Tasks are identified by number and dispatched with a switch
+ *          in the caller, which keeps the C51 call tree (and data overlaying) static.
+ */
+
+#ifndef __SCHED_H__
+#define __SCHED_H__
+
+#include "sys.h"
+
+// --- Configuration ---
+#define SCHED_MAX_TASKS     8                   /**< Size of the task table */
+#define SCHED_IDLE          0xFF                /**< Sched_Next(): nothing is due */
+#define SCHED_TICKS_PER_MS  TICK_COUNTS_PER_MS  /**< Timer 2 counts per ms (stamp unit) */
+
+// --- Structures ---
+/**
+ * @brief Scheduler Task Control Block
+ * @details Times in ms except the run-time fields, which are in Timer 2 counts
+ *          (SCHED_TICKS_PER_MS per ms, ~58 ns).
+ */
+typedef struct _sched_task
+{
+    u16 period;     // Period in ms (0 = slot unused)
+    u16 deadline;   // Wait_Count value at which the task is due
+    u8  prio;       // Priority, 0 = most urgent
+    u16 runs;       // Number of completed runs
+    u16 overruns;   // Runs that started more than one period late
+    u16 jitter_max; // Largest start delay past the deadline (ms)
+    u32 run_max;    // Longest run time
+    u32 run_total;  // Sum of run times (average = run_total / runs)
+} sched_task;
+
+// --- Global External Variables ---
+extern sched_task Sched_Tasks[SCHED_MAX_TASKS];
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Register a periodic task
+ * @param id Task number (0 .. SCHED_MAX_TASKS-1)
+ * @param period Period in ms
+ * @param offset Delay of the first run in ms (spreads tasks with equal periods)
+ * @param prio Priority, 0 = most urgent
+ */
+void Sched_Add(u8 id, u16 period, u16 offset, u8 prio);
+
+/**
+ * @brief Pick the most urgent due task
+ * @details Costs one 16-bit compare while nothing is due.
+ * @return Task number, or SCHED_IDLE
+ */
+u8 Sched_Next(void);
+
+/**
+ * @brief Account a finished run and schedule the next deadline
+ * @param id Task number returned by Sched_Next()
+ */
+void Sched_Done(u8 id);
+
+/**
+ * @brief Free-running time stamp in Timer 2 counts
+ * @return Wait_Count * SCHED_TICKS_PER_MS + counts into the current ms
+ */
+u32 Sched_Stamp(void);
+
+#endif
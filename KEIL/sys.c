@@ -8,6 +8,11 @@
 
 #include "sys.h"
 #include "uart.h"
+#include "dgus.h"
+#include "prof.h"
+#include "pt.h"
+#include "flash.h"
+#include "vp_bind.h"
 #include "string.h"
 #include <intrins.h>
 
@@ -17,12 +22,17 @@ const u8 code mon_table[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
 const u8 code time_set_init[6] = {19,5,1,12,00,00};
 
 // --- System Global Variables ---
-/** @brief System tick counter, incremented every ms by Timer 0 ISR. Volatile for safe ISR access. */
+/** @brief System tick counter, incremented every ms by the Timer 2 ISR. Volatile for safe ISR access. */
 volatile u16 data Wait_Count = 0;          
-/** @brief Internal counter for the RTC tick, used to measure 1-second intervals. */
-static u16 data SysTick_RTC = 0;  
-/** @brief Countdown variable for the `delay_ms` function. */
-static u16 data SysTick = 0;      
+/** @brief Timer 2 counts accumulated towards the next RTC second (TICK_COUNTS_PER_MS per tick). */
+static u32 data rtc_counts = 0;
+/** @brief Timer 2 counts per RTC second, nominal FOSC/12 corrected by the ppm trim. */
+static u32 rtc_counts_per_sec = RTC_COUNTS_PER_SEC;
+/** @brief Software timers: ms left, reload, and one active / expired bit per slot. */
+static u16 stimer_remain[STIMER_COUNT];
+static u16 stimer_period[STIMER_COUNT];
+static volatile u8 data stimer_active = 0;
+static volatile u8 data stimer_expired = 0;
 /** @brief Global structure holding the current real-time clock time. */
 rtc_time real_time;             
 /** @brief Flag set by the RTC ISR every second to signal the main loop to update the display. */
@@ -120,13 +130,15 @@ void PORT_Init(void)
     P1MDOUT = 0xFF; 
     // P1 |= 0xEA; // Removed Input High-Z forcing
 
-    // P2: Set P2.0 to Push-Pull for PWM (1kHz)
-    P2MDOUT |= 0x03; // P2.0 (PWM) + P2.1 (Original)
+    // P2: P2.0/P2.1 Push-Pull (P2.0 carried the old Timer 2 software PWM; the
+    // 1kHz output is hardware PWM0 now, which has its own pin)
+    P2MDOUT |= 0x03; // P2.0 + P2.1 (Original)
 }
 
 /**
  * @brief Initialize the software Real-Time Clock.
  * @details Loads the `real_time` structure with a default compile-time date and time.
+ *          The day of week is computed here once; T1_ISR_PC advances it with the date.
  */
 void RTC_Init(void)
 {
@@ -137,66 +149,175 @@ void RTC_Init(void)
     real_time.hour = time_set_init[3];
     real_time.min = time_set_init[4];
     real_time.sec = time_set_init[5];
+    real_time.week = RTC_Get_Week(real_time.year, real_time.month, real_time.day);
+    RTC_Set_Trim(RTC_TRIM_PPM);
 }
 
 /**
- * @brief Initialize Timer 0 for System Tick.
- * @details Configures Timer 0 to generate an interrupt every 1ms, which serves as the main system tick.
+ * @brief Set the RTC frequency trim.
+ * @details A fast oscillator delivers more timer counts per real second, so the
+ *          count threshold of one RTC second grows by FOSC/12 * ppm / 1e6
+ *          (17.2 counts per ppm); one count of the threshold is ~0.06 ppm.
+ * @param ppm Oscillator error in ppm, + = fast (clock would gain time)
  */
-void T0_Init(void)
+void RTC_Set_Trim(s16 ppm)
 {
-    // System Tick Timer
-    TMOD |= 0x01;         
-    TH0 = T1MS >> 8;        
-    TL0 = T1MS;           
-    ET0 = 1;              
-    EA = 1;               
-    TR0 = 1;              
-}
+    u32 n = RTC_COUNTS_PER_SEC + ((s32)ppm * (s32)(RTC_COUNTS_PER_SEC / 1000UL) / 1000L);
 
-/**
- * @brief Initialize Timer 1 for RTC Tick.
- * @details Configures Timer 1 to generate a 1ms interrupt used for the software RTC counting.
- */
-void T1_Init(void)
-{
-    // RTC Tick Timer
-    TMOD |= 0x10;        
-    TH1 = T1MS >> 8;        
-    TL1 = T1MS;           
-    ET1 = 1;              
-    EA = 1;               
-    TR1 = 1;              
+    ET2 = 0;
+    rtc_counts_per_sec = n;
+    ET2 = 1;
 }
 
 /**
- * @brief Initialize Timer 2.
- * @details Configures Timer 2 for 500us interrupts to generate 1kHz PWM on P2.0.
- *          500us High + 500us Low = 1ms Period = 1kHz.
+ * @brief Initialize Timer 2 as the single system tick.
+ * @details Timer 2 reloads itself from TRL2H/TRL2L every TICK_US (1ms), so the
+ *          tick period carries no interrupt latency. Timers 0 and 1 stay stopped
+ *          and are free for other uses.
  */
 void T2_Init(void)
 {
     T2CON = 0x70;       // 16-bit Auto-reload
-    TH2 = 0x00;
-    TL2 = 0x00;
     
-    // Reload value for 500us (17.2032 MHz clock)
-    // 65536 - (17203200 * 0.0005) = 56934 = 0xDE66
-    TRL2H = 0xDE;       
-    TRL2L = 0x66;       
+    // Reload value for 1ms (17.2032 MHz clock)
+    // 65536 - 17203 = 48333 = 0xBCCD
+    TRL2H = (u8)(TICK_RELOAD >> 8);
+    TRL2L = (u8)TICK_RELOAD;
+    TH2 = (u8)(TICK_RELOAD >> 8);
+    TL2 = (u8)TICK_RELOAD;
     
-    IEN0 |= 0x20;       // Enable Timer 2 Interrupt (ET2)
+    ET2 = 1;            // Enable Timer 2 Interrupt
+    EA = 1;
     TR2 = 1;            // Start Timer 2
 }
 
 /**
- * @brief Timer 2 Interrupt Service Routine.
- * @details Toggles P2.0 every 500us to create a 1kHz square wave (50% Duty Cycle).
+ * @brief Advance the software RTC by one second (Timer 2 ISR context only).
+ * @details Date rollover follows the Gregorian calendar, the day of week
+ *          advances with the date.
+ */
+static void rtc_second(void)
+{
+    u8 days;
+
+    Second_Updata_Flag = 1; // Flag to update display in main loop
+    if(++real_time.sec < 60) return;
+    real_time.sec = 0;
+    if(++real_time.min < 60) return;
+    real_time.min = 0;
+    if(++real_time.hour < 24) return;
+    real_time.hour = 0;
+
+    // --- Date change ---
+    if(++real_time.week > 6) real_time.week = 0;
+
+    days = mon_table[real_time.month - 1];
+    if(real_time.month == 2 && (real_time.year & 0x03) == 0 && real_time.year != 100 && real_time.year != 200)
+    {
+        days = 29; // Leap year (2000-2255: every 4th year except 2100 and 2200)
+    }
+    if(++real_time.day <= days) return;
+    real_time.day = 1;
+    if(++real_time.month <= 12) return;
+    real_time.month = 1;
+    real_time.year++;
+}
+
+/**
+ * @brief Timer 2 Interrupt Service Routine (System Tick, every TICK_US).
+ * @details The one hardware tick serves every timebase client: each tick
+ *          advances Wait_Count (scheduler, timeouts), the software timers
+ *          (delay_ms and STimer_*) and the RTC. The 1kHz square wave is hardware
+ *          PWM0 on its own pin (PWM_Set()).
+ *          The RTC accumulates the exact Timer 2 counts of each ms; a second
+ *          elapses when rtc_counts_per_sec counts (FOSC/12, trimmed) have
+ *          accumulated, which absorbs both the rounding of TICK_COUNTS and the
+ *          oscillator error.
  */
 void T2_ISR_PC(void) interrupt 5
 {
+    u8 i, m;
+
     TF2 = 0;        // Clear Overflow Flag (Hardware should do this in auto-reload, but safe to ensure)
-    P2_0 = !P2_0;   // Toggle P2.0
+
+    Wait_Count++;
+
+    // Software timers
+    if(stimer_active)
+    {
+        for(i = 0, m = 0x01; i < STIMER_COUNT; i++, m <<= 1)
+        {
+            if(!(stimer_active & m) || --stimer_remain[i]) continue;
+            stimer_expired |= m;
+            if(stimer_period[i]) stimer_remain[i] = stimer_period[i];
+            else stimer_active &= ~m;
+        }
+    }
+
+    // RTC
+    rtc_counts += TICK_COUNTS_PER_MS;
+    if(rtc_counts >= rtc_counts_per_sec)
+    {
+        rtc_counts -= rtc_counts_per_sec;
+        rtc_second();
+    }
+}
+
+/**
+ * @brief Start a software timer.
+ * @param id Timer slot
+ * @param ms First expiry in ms (0 = expire on the next ms)
+ * @param period Reload in ms for periodic timers, 0 = one-shot
+ */
+void STimer_Start(u8 id, u16 ms, u16 period)
+{
+    u8 m;
+
+    if(id >= STIMER_COUNT) return;
+    m = 0x01 << id;
+
+    ET2 = 0;
+    stimer_remain[id] = ms ? ms : 1;
+    stimer_period[id] = period;
+    stimer_expired &= ~m;
+    stimer_active |= m;
+    ET2 = 1;
+}
+
+/**
+ * @brief Stop a software timer and clear its expiry flag.
+ * @param id Timer slot
+ */
+void STimer_Stop(u8 id)
+{
+    u8 m;
+
+    if(id >= STIMER_COUNT) return;
+    m = 0x01 << id;
+
+    ET2 = 0;
+    stimer_active &= ~m;
+    stimer_expired &= ~m;
+    ET2 = 1;
+}
+
+/**
+ * @brief Poll a software timer.
+ * @param id Timer slot
+ * @return 1 once per expiry, 0 otherwise
+ */
+u8 STimer_Expired(u8 id)
+{
+    u8 m;
+
+    if(id >= STIMER_COUNT) return 0;
+    m = 0x01 << id;
+    if(!(stimer_expired & m)) return 0;
+
+    ET2 = 0;
+    stimer_expired &= ~m;
+    ET2 = 1;
+    return 1;
 }
 
 // =============================================================================
@@ -206,7 +327,8 @@ void T2_ISR_PC(void) interrupt 5
 /**
  * @brief Write data to DGUS Variable Pointer (VP) memory.
  * @details Optimized for DWIN T5L. Handles atomic 32-bit accesses, odd/even alignment,
- *          and supports multi-byte buffers.
+ *          and supports multi-byte buffers. Words of the user VP range that the
+ *          shadow RAM already holds are not rewritten.
  *          CRITICAL: Disables Global Interrupts (EA) during hardware access to prevent corruption.
  * @param addr 16-bit VP Address
  * @param vbuf Pointer to source buffer
@@ -215,11 +337,19 @@ void T2_ISR_PC(void) interrupt 5
 void write_dgus_vp(u32 addr, void* vbuf, u16 len)
 {
     u8* buf = (u8*)vbuf;
-    u32 OS_addr = addr >> 1;
-    u8 is_odd = addr & 0x01;
+    u32 OS_addr;
+    u8 is_odd;
     u8 mask;
+
+    // Drop words the shadow RAM already holds (see dgus.c), and queued bytes
+    // this write replaces (a flush must not bring the older value back)
+    if(!shadow_dgus_write(&addr, &buf, &len)) return;
+    dgus_unqueue(addr, len);
+    OS_addr = addr >> 1;
+    is_odd = addr & 0x01;
     
     EA = 0; // Disable Interrupts for Atomic Access
+    PROF_EA_BEGIN();
 
     // 1. Set Initial Address
     ADR_H = (u8)(OS_addr >> 16);
@@ -285,13 +415,16 @@ void write_dgus_vp(u32 addr, void* vbuf, u16 len)
     }
 
     RAMMODE = 0x00; // Release Access
+    PROF_EA_STAMP();
     EA = 1;         // Restore Interrupts
+    PROF_EA_END(PROF_DGUS_WRITE);
 }
 
 /**
  * @brief Read data from DGUS Variable Pointer (VP) memory.
  * @details Handles atomic 32-bit accesses, odd/even alignment, and supports multi-byte buffers.
  *          CRITICAL: Disables Global Interrupts (EA) during hardware access.
+ *          Data read from the shadowed user VP range refreshes the shadow RAM.
  * @param addr 16-bit VP Address
  * @param vbuf Pointer to destination buffer
  * @param len Length of data in bytes
@@ -301,8 +434,10 @@ void read_dgus_vp(u32 addr, void* vbuf, u16 len)
     u8* buf = (u8*)vbuf;
     u32 OS_addr = addr >> 1;
     u8 is_odd = addr & 0x01;
+    u16 total = len;
     
     EA = 0; // Disable Interrupts
+    PROF_EA_BEGIN();
 
     // 1. Set Initial Address
     ADR_H = (u8)(OS_addr >> 16);
@@ -355,24 +490,15 @@ void read_dgus_vp(u32 addr, void* vbuf, u16 len)
     }
 
     RAMMODE = 0x00;
+    PROF_EA_STAMP();
     EA = 1; // Restore Interrupts
+    PROF_EA_END(PROF_DGUS_READ);
+
+    shadow_dgus_read(addr, (u8*)vbuf, total);
 }
 
 // --- Interrupt Service Routines & Logic ---
 
-/**
- * @brief Timer 0 Interrupt Service Routine.
- * @details This ISR is triggered every 1ms. It reloads the timer, increments the main system
- *          `Wait_Count`, and decrements the `SysTick` counter for `delay_ms`.
- */
-void T0_ISR_PC(void) interrupt 1
-{
-    TH0 = T1MS >> 8;    
-    TL0 = T1MS;       
-    Wait_Count++;   
-    if(SysTick > 0) SysTick--;
-}
-
 /**
  * @brief Calculates the day of the week from a given date.
  * @param year The year (e.g., 24 for 2024).
@@ -405,143 +531,90 @@ u8 RTC_Get_Week(u8 year, u8 month, u8 day)
 /**
  * @brief Updates RTC logic and synchronizes with DGUS Display.
  * @details Called from main loop. Uses non-overlapping addresses 
- * (0x2010, 0x2020, 0x2030) as confirmed working.
+ * (VP_RTC_HOUR/MIN/SEC, vp_bind.cfg) as confirmed working. The values go to
+ * the VP binding mirror and reach DGUS RAM with the main loop's Vpb_Sync().
  */
 void Time_Update(void)
 {
-    u16 hour_val, min_val, sec_val;
-
     MUX_SEL |= 0x01; // Feed Watchdog (Reset WDT) [cite: 1810]
     
     if(Second_Updata_Flag == 1)
     {
-        real_time.week = RTC_Get_Week(real_time.year, real_time.month, real_time.day);
-        
-        // Prepare local variables (u16)
-        hour_val = real_time.hour;
-        min_val = real_time.min;
-        sec_val = real_time.sec;
-
         // --- WRITE TO DGUS VP ---
-        // Using strict Even addresses spaced out to ensure no overlap.
-        // Function write_dgus_vp will handle the 2-byte write safely.
-        
-        write_dgus_vp(0x2010, &hour_val, 2); 
-        // No delay needed here with the correct 'while(APP_EN)' check in write_dgus_vp, 
-        // but keeping small delay is safe for bus stability if desired.
-        
-        write_dgus_vp(0x2020, &min_val, 2);  
-        
-        write_dgus_vp(0x2030, &sec_val, 2);  
+        // Only changed values are written (hour/min rarely change).
+        Vpb_Set(VPB_RTC_HOUR, real_time.hour);
+        Vpb_Set(VPB_RTC_MIN, real_time.min);
+        Vpb_Set(VPB_RTC_SEC, real_time.sec);
         
         Second_Updata_Flag = 0;
     }
 }
 
-/**
- * @brief Timer 1 Interrupt Service Routine.
- * @details This ISR is triggered every 1ms to drive the software RTC. It increments a counter
- *          and, upon reaching 1000ms (1 second), it updates the `real_time` structure and
- *          sets a flag for the main loop to update the display.
- */
-void T1_ISR_PC(void) interrupt 3
-{
-    TH1 = T1MS >> 8;
-    TL1 = T1MS;
-    SysTick_RTC++;
-    
-    // 1 Second Heartbeat
-    if(SysTick_RTC >= 1000)
-    {
-        SysTick_RTC = 0;
-        real_time.sec++;
-        if(real_time.sec > 59)
-        {
-            real_time.sec = 0;
-            real_time.min++;
-            if(real_time.min > 59)
-            {
-                real_time.min = 0;
-                real_time.hour++;
-                if(real_time.hour > 23)
-                {
-                    real_time.hour = 0;
-                    real_time.day++;
-                    // Basic Month/Day logic (simplified)
-                    if(real_time.day > 28) { 
-                        // Full calendar logic should go here if needed
-                    } 
-                }
-            }
-        }
-        Second_Updata_Flag = 1; // Flag to update display in main loop
-    }
-}
-
 /**
  * @brief Provides a blocking delay for a specified number of milliseconds.
- * @details This function uses a global counter `SysTick` which is decremented by the Timer 0 ISR.
- *          It is a "busy-wait" or "cooperative" delay, not a true sleep.
+ * @details This function uses software timer STIMER_DELAY, counted down by the Timer 2 ISR.
+ *          It is a "busy-wait" delay, not a true sleep: nothing else in the main loop
+ *          runs meanwhile. Use PT_SLEEP (pt.h) for waits inside long operations.
  * @param n The number of milliseconds to delay.
  */
 void delay_ms(u16 n)
 {
-    SysTick = n;
-    while(SysTick);
+    if(n == 0) return;
+    STimer_Start(STIMER_DELAY, n, 0);
+    while(!STimer_Expired(STIMER_DELAY));
 }
+
 /**
  * @brief Upisuje cijeli 16.icl fajl (256KB) koristeci podatke sa RAM adrese 0x1000.
- * @details Ponavlja upis istog 32KB RAM buffera 8 puta na uzastopne Flash adrese.
- * Koristi 'delay_ms' da osigura da GUI jezgro stigne obraditi svaki blok.
+ * @details Uzorak od 32KB sa 0x1000 se kopira u slobodni staging buffer (flash.h) i
+ * predaje engine-u, 8 puta na uzastopne Flash blokove. Dok GUI jezgro pie jedan
+ * buffer, ovdje se puni drugi (po FLASH_FILL_BYTES u svakom prolazu petlje).
+ * Kraj bloka engine prepoznaje citanjem 0x00AA, bez fiksnog cekanja.
+ * Protothread (pt.h): poziva se iz glavne petlje dok ne vrati PT_ENDED.
+ * @param p Kontekst protothread-a (PT_INIT prije prvog poziva)
+ * @return PT_WAITING dok upis traje, PT_ENDED kad je svih 8 blokova upisano
  */
-void Test_Flash_Write_Full_16ICL(void)
+#define FLASH_FILL_BYTES    128
+u8 Test_Flash_Write_Full_16ICL(pt* p)
 {
-    u8 i;
-    u8 cmd_buffer[12];
-    
+    static u8 i;        // Prezivljava PT_YIELD
+    static u16 buf_vp;  // Buffer koji se trenutno puni
+    static u16 ofs;     // Popunjeno (VP rijeci)
+    static u8 xdata chunk[FLASH_FILL_BYTES];
+
     // Proracun pocetnog bloka za ID 16:
     // Svaki ID = 256KB. Komanda pie 32KB.
     // 256 / 32 = 8 blokova po ID-u.
     // Pocetni blok = 16 * 8 = 128 (0x0080).
     u16 start_block_addr = 0x0080; 
 
+    PT_BEGIN(p);
+
     // Petlja od 0 do 7 (ukupno 8 blokova)
     for(i = 0; i < 8; i++)
     {
-        // --- 1. Priprema komande za VP 0x00AA ---
-
-        // D11:D10 - Enable (0x5A) & Mode (0x02 - Write 32KB)
-        cmd_buffer[0] = 0x5A;
-        cmd_buffer[1] = 0x02;
-
-        // D9:D8 - Flash Block Address
-        // U prvoj iteraciji 0x0080, u drugoj 0x0081, itd...
-        cmd_buffer[2] = (u8)((start_block_addr + i) >> 8); 
-        cmd_buffer[3] = (u8)(start_block_addr + i);        
-
-        // D7:D6 - Source RAM Address
-        // Uvijek uzimamo isti uzorak sa 0x1000 kako ste traili
-        cmd_buffer[4] = 0x10;
-        cmd_buffer[5] = 0x00;
-
-        // D5:D4 - Delay/Safety Wait (Parametar za GUI jezgro)
-        // Kaemo GUI jezgru da priceka 100ms nakon upisa
-        cmd_buffer[6] = 0x00;
-        cmd_buffer[7] = 0x64; 
-
-        // D3:D0 - Reserved (0x00)
-        cmd_buffer[8] = 0x00;
-        cmd_buffer[9] = 0x00;
-        cmd_buffer[10] = 0x00;
-        cmd_buffer[11] = 0x00;
-
-        // --- 2. Slanje komande ---
-        write_dgus_vp(0x00AA, cmd_buffer, 12);
-
-        // --- 3. Obavezno cekanje ---
-        // Moramo pauzirati OS jezgro da ne pregazimo komandu dok GUI jezgro pie u Flash.
-        // 200ms je sigurna margina (32KB upis traje neko vrijeme).
-        delay_ms(200); 
+        // --- 1. Slobodan buffer (najvie jedan blok ceka iza onog koji se pie) ---
+        // (timeout bloka zavrsava posao i zakljucava buffere)
+        PT_WAIT_UNTIL(p, (i && Flash_Stats.errors) || (buf_vp = Flash_Free_Buffer()) != 0);
+        if(i && Flash_Stats.errors) break;
+
+        // --- 2. Punjenje, malo po malo, dok GUI jezgro radi ---
+        for(ofs = 0; ofs < FLASH_BLOCK_WORDS; ofs += FLASH_FILL_BYTES / 2)
+        {
+            read_dgus_vp(0x1000 + ofs, chunk, FLASH_FILL_BYTES);
+            write_dgus_vp(buf_vp + ofs, chunk, FLASH_FILL_BYTES);
+            PT_YIELD(p);
+        }
+
+        // --- 3. Predaja engine-u ---
+        PT_WAIT_UNTIL(p, (i && Flash_Stats.errors) || Flash_Submit(start_block_addr + i, buf_vp) == 0);
+        if(i && Flash_Stats.errors) break;
     }
+
+    // --- 4. Kraj posljednjeg bloka + izvjetaj (blokovi, ms, KB/s) ---
+    PT_WAIT_UNTIL(p, Flash_Idle());
+    Flash_Report();
+
+    PT_END(p);
 }
 
@@ -8,7 +8,7 @@
 #ifndef __SYS_H__
 #define __SYS_H__
 
-#include "t5los8051.h" // Include the hardware register definitions
+#include "T5LOS8051.h" // Include the hardware register definitions
 
 // --- Type Definitions for Cross-Platform Compatibility ---
 typedef unsigned char   u8;     // 8-bit unsigned integer
@@ -26,8 +26,22 @@ typedef long            s32;    // 32-bit signed integer
 // --- System Constants ---
 // Oscillator Frequency (T5L Core frequency approx 206 MHz)
 #define FOSC     206438400UL 
-// Timer Reload Value for 1ms interrupt (12 clocks per machine cycle)
-#define T1MS    (65536-FOSC/12/1000)
+// System tick: Timer 2 in 16-bit auto-reload mode (12 clocks per count), one
+// interrupt per TICK_US, i.e. one ms of Wait_Count per interrupt (the PWM
+// output is in hardware, so no sub-ms tick is needed).
+#define TICK_US             1000
+// Timer 2 counts per tick, rounded (17203 = 0.99999ms)
+#define TICK_COUNTS         ((FOSC/12/1000*TICK_US+500)/1000)
+#define TICK_RELOAD         (65536-TICK_COUNTS)
+// Timer 2 counts per ms of Wait_Count
+#define TICK_COUNTS_PER_MS  ((u32)TICK_COUNTS)
+// Nominal Timer 2 counts per second (FOSC/12)
+#define RTC_COUNTS_PER_SEC  (FOSC/12)
+// Default RTC trim in ppm (+ = oscillator fast, clock gains time untrimmed)
+#define RTC_TRIM_PPM        0
+// Software timers served by the tick (slot 0 belongs to delay_ms)
+#define STIMER_DELAY        0
+#define STIMER_COUNT        4
 #define NULL ((void *)0)
 
 // --- Structures ---
@@ -70,19 +84,30 @@ void PORT_Init(void);
 void RTC_Init(void);
 
 /**
- * @brief Initialize Timer 0
+ * @brief Initialize Timer 2 (System Tick)
  */
-void T0_Init(void);
+void T2_Init(void);
 
 /**
- * @brief Initialize Timer 1
+ * @brief Start a software timer
+ * @param id Timer slot (0 .. STIMER_COUNT-1)
+ * @param ms First expiry in ms (0 = expire on the next ms)
+ * @param period Reload in ms for periodic timers, 0 = one-shot
  */
-void T1_Init(void);
+void STimer_Start(u8 id, u16 ms, u16 period);
 
 /**
- * @brief Initialize Timer 2
+ * @brief Stop a software timer and clear its expiry flag
+ * @param id Timer slot
  */
-void T2_Init(void);
+void STimer_Stop(u8 id);
+
+/**
+ * @brief Poll a software timer
+ * @param id Timer slot
+ * @return 1 once per expiry, 0 otherwise
+ */
+u8 STimer_Expired(u8 id);
 
 /**
  * @brief Read from DGUS Variable Pointer (VP) memory
@@ -105,6 +130,12 @@ void write_dgus_vp(u32 addr,void* buf,u16 len);
  */
 u8 RTC_Get_Week(u8 year,u8 month,u8 day);
 
+/**
+ * @brief Set the RTC frequency trim
+ * @param ppm Oscillator error in ppm, + = fast (clock would gain time)
+ */
+void RTC_Set_Trim(s16 ppm);
+
 /**
  * @brief Routine to update time logic and display
  */
@@ -116,4 +147,13 @@ void Time_Update(void);
  */
 void delay_ms(u16 n);
 
+struct _pt;     // pt.h (includes this header)
+
+/**
+ * @brief Flash write test: 8 x 32 KB from RAM 0x1000 to the blocks of 16.icl
+ * @param p Protothread context (PT_INIT before the first call)
+ * @return PT_WAITING while writing, PT_ENDED when all 8 blocks are written
+ */
+u8 Test_Flash_Write_Full_16ICL(struct _pt* p);
+
 #endif
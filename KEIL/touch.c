@@ -0,0 +1,177 @@
+/**
+ * @file touch.c
+ * @brief Touch Panel Event Subsystem.
+ * @details VP_TP_STATUS holds 0x5A when the GUI core has posted a new status,
+ *          the status (0x01 press, 0x02 release, 0x03 pressing) and the big-endian
+ *          X and Y coordinates. Edges are found by comparing with the previous
+ *          poll. A whole tap between two polls only leaves 0x5A with 0x02 (or,
+ *          while a touch is down, 0x01 for release-and-press again), so the 0x5A
+ *          flag is checked for those and cleared after every poll that saw it;
+ *          the tap is delivered as both edges. A status posted between the read
+ *          and the flag clear is still judged by the status alone on the next
+ *          poll. The zone a touch starts in owns the whole gesture: drags and the
+ *          release go to it even after the finger left, a long press only fires
+ *          while still inside.
+ */
+
+#include "touch.h"
+#include "DWIN_GUI_VP.h"
+
+static touch_zone touch_zones[TOUCH_MAX_ZONES];
+
+u16 Touch_X = 0, Touch_Y = 0;
+
+/** @brief Gesture state. */
+static bit touch_down = 0;
+static bit touch_long_done = 0;
+static bit touch_dragging = 0;
+static u8 touch_zone_id = TOUCH_NO_ZONE;
+static u16 touch_start;             // Wait_Count at press
+static u16 touch_x0, touch_y0;      // Press point
+
+/**
+ * @brief Register (or replace) a hot zone.
+ */
+void Touch_Add_Zone(u8 id, u16 x0, u16 y0, u16 x1, u16 y1, u16 long_ms)
+{
+    touch_zone* z;
+
+    if(id >= TOUCH_MAX_ZONES) return;
+    z = &touch_zones[id];
+    z->x0 = x0;
+    z->y0 = y0;
+    z->x1 = x1;
+    z->y1 = y1;
+    z->long_ms = long_ms;
+    z->used = 1;
+}
+
+/**
+ * @brief Test a point against one zone.
+ */
+static u8 touch_inside(u8 id, u16 x, u16 y)
+{
+    touch_zone* z = &touch_zones[id];
+    return z->used && x >= z->x0 && x <= z->x1 && y >= z->y0 && y <= z->y1;
+}
+
+/**
+ * @brief First zone containing the point, or TOUCH_NO_ZONE.
+ */
+static u8 touch_find(u16 x, u16 y)
+{
+    u8 i;
+    for(i = 0; i < TOUCH_MAX_ZONES; i++)
+    {
+        if(touch_inside(i, x, y)) return i;
+    }
+    return TOUCH_NO_ZONE;
+}
+
+/** @brief Absolute difference of two coordinates. */
+#define TOUCH_DIST(a, b)    (((a) > (b)) ? ((a) - (b)) : ((b) - (a)))
+
+/**
+ * @brief Start a gesture at (Touch_X, Touch_Y).
+ */
+static void touch_press(void)
+{
+    touch_down = 1;
+    touch_long_done = 0;
+    touch_dragging = 0;
+    touch_start = Wait_Count;
+    touch_x0 = Touch_X;
+    touch_y0 = Touch_Y;
+    touch_zone_id = touch_find(Touch_X, Touch_Y);
+    Touch_Event(touch_zone_id, TOUCH_EV_PRESS);
+}
+
+/**
+ * @brief End the gesture.
+ */
+static void touch_release(void)
+{
+    touch_down = 0;
+    Touch_Event(touch_zone_id, TOUCH_EV_RELEASE);
+    touch_zone_id = TOUCH_NO_ZONE;
+}
+
+/**
+ * @brief Read the touch status once and dispatch the resulting events.
+ */
+void Touch_Poll(void)
+{
+    u8 tp[8];
+    u8 pressed;
+    u8 posted;
+    touch_zone* z;
+
+    read_dgus_vp(VP_TP_STATUS, tp, 8);
+
+    posted = (tp[0] == 0x5A);
+    if(posted)
+    {
+        // Clear only the flag byte; the status stays for the edge compare
+        tp[0] = 0x00;
+        write_dgus_vp(VP_TP_STATUS, tp, 1);
+    }
+
+    pressed = (tp[1] == 0x01 || tp[1] == 0x03);
+    if(pressed || posted)
+    {
+        Touch_X = ((u16)tp[2] << 8) | tp[3];
+        Touch_Y = ((u16)tp[4] << 8) | tp[5];
+    }
+
+    if(posted && tp[1] == 0x02 && !touch_down)
+    {
+        // --- Whole tap between two polls ---
+        touch_press();
+        touch_release();
+    }
+    else if(posted && tp[1] == 0x01 && touch_down)
+    {
+        // --- Released and pressed again between two polls ---
+        touch_release();
+        touch_press();
+    }
+    else if(pressed && !touch_down)
+    {
+        // --- Press edge ---
+        touch_press();
+    }
+    else if(pressed)
+    {
+        // --- Held ---
+        if(!touch_dragging &&
+           (TOUCH_DIST(Touch_X, touch_x0) > TOUCH_DRAG_PX || TOUCH_DIST(Touch_Y, touch_y0) > TOUCH_DRAG_PX))
+        {
+            touch_dragging = 1;
+        }
+        if(touch_dragging && (Touch_X != touch_x0 || Touch_Y != touch_y0))
+        {
+            touch_x0 = Touch_X;
+            touch_y0 = Touch_Y;
+            Touch_Event(touch_zone_id, TOUCH_EV_DRAG);
+        }
+
+        if(touch_zone_id != TOUCH_NO_ZONE && !touch_long_done)
+        {
+            z = &touch_zones[touch_zone_id];
+            if(z->long_ms == 0 || !touch_inside(touch_zone_id, Touch_X, Touch_Y))
+            {
+                touch_long_done = 1; // Left the zone: no long press for this touch
+            }
+            else if((u16)(Wait_Count - touch_start) >= z->long_ms)
+            {
+                touch_long_done = 1;
+                Touch_Event(touch_zone_id, TOUCH_EV_LONG);
+            }
+        }
+    }
+    else if(touch_down)
+    {
+        // --- Release edge ---
+        touch_release();
+    }
+}
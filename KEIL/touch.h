@@ -0,0 +1,76 @@
+/**
+ * @file touch.h
+ * @brief Touch Panel Event Subsystem Header File.
+ * @details Touch_Poll() reads VP_TP_STATUS once per call (the main loop schedules
+ *          it every TOUCH_POLL_MS), tracks the finger and turns status changes into
+ *          events for up to TOUCH_MAX_ZONES rectangular hot zones:
+ *          - TOUCH_EV_PRESS    finger down inside the zone
+ *          - TOUCH_EV_RELEASE  finger up after a press that started in the zone
+ *          - TOUCH_EV_LONG     finger held inside the zone for the zone's long_ms
+ *          - TOUCH_EV_DRAG     finger moved more than TOUCH_DRAG_PX from the press point
+ *          Events are delivered to Touch_Event(), which the application defines.
+ *          A link-time callback instead of function pointers keeps the C51 call
+ *          tree static, as with the scheduler task switch.
+ */
+
+#ifndef __TOUCH_H__
+#define __TOUCH_H__
+
+#include "sys.h"
+
+// --- Configuration ---
+#define TOUCH_MAX_ZONES     4       /**< Size of the hot zone table */
+#define TOUCH_POLL_MS       20      /**< Poll period the main loop schedules Touch_Poll() at */
+#define TOUCH_DRAG_PX       8       /**< Movement from the press point that starts a drag */
+#define TOUCH_NO_ZONE       0xFF    /**< Touch_Event() zone for touches outside all zones */
+
+// --- Events ---
+#define TOUCH_EV_PRESS      0x01
+#define TOUCH_EV_RELEASE    0x02
+#define TOUCH_EV_LONG       0x03
+#define TOUCH_EV_DRAG       0x04
+
+// --- Structures ---
+/**
+ * @brief Touch Hot Zone
+ * @details Bounds are inclusive panel coordinates. long_ms = 0 disables
+ *          TOUCH_EV_LONG for the zone.
+ */
+typedef struct _touch_zone
+{
+    u16 x0, y0;     // Top left corner
+    u16 x1, y1;     // Bottom right corner
+    u16 long_ms;    // Hold time for TOUCH_EV_LONG (0 = off)
+    u8  used;       // Slot in use
+} touch_zone;
+
+// --- Global External Variables ---
+/** @brief Latest touch coordinates (valid inside Touch_Event()). */
+extern u16 Touch_X, Touch_Y;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Register (or replace) a hot zone
+ * @param id Zone number (0 to TOUCH_MAX_ZONES-1)
+ * @param x0 Left edge
+ * @param y0 Top edge
+ * @param x1 Right edge
+ * @param y1 Bottom edge
+ * @param long_ms Hold time for TOUCH_EV_LONG in ms, 0 = no long press
+ */
+void Touch_Add_Zone(u8 id, u16 x0, u16 y0, u16 x1, u16 y1, u16 long_ms);
+
+/**
+ * @brief Read the touch status once and dispatch the resulting events
+ */
+void Touch_Poll(void);
+
+/**
+ * @brief Application callback for touch events (defined by the application)
+ * @param zone Zone number, or TOUCH_NO_ZONE
+ * @param event TOUCH_EV_* code
+ */
+void Touch_Event(u8 zone, u8 event);
+
+#endif
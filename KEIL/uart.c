@@ -3,14 +3,23 @@
  * @brief UART Communication Driver.
  * @details This file manages UART5 (UART3 in some DWIN docs terminology relative to SFRs,
  *          but logically handled as the primary comms channel here).
- *          It implements a circular buffer for reception and basic blocking transmission.
+ *          It implements circular buffers for reception and transmission. Transmission
+ *          is interrupt-driven: the TX ISR feeds SBUF3_TX from the ring and releases
+ *          the RS485 driver once the stop bit of the last byte has left the line.
  */
 
 #include "uart.h"
 
-volatile u8 Rx_Buffer[32];
+volatile u8 Rx_Buffer[UART5_RX_SIZE];
 volatile u8 Rx_Head = 0;
 volatile u8 Rx_Tail = 0;
+volatile u16 Rx_Overflow = 0;
+
+volatile u8 Tx_Buffer[UART5_TX_SIZE];
+volatile u8 Tx_Head = 0;
+volatile u8 Tx_Tail = 0;
+/** @brief Set while a byte is in SBUF3_TX; cleared by the TX ISR when the ring runs dry. */
+static volatile bit Tx_Active = 0;
 
 /**
  * @brief Initialize UART5
@@ -25,27 +34,44 @@ void UART5_Init(void)
     BODE3_DIV_H=0x00;
     BODE3_DIV_L=0xE0;
     ES3R=1;             // Enable UART5 Receive Interrupt
+    ES3T=1;             // Enable UART5 Transmit Interrupt
     RS485_TX_EN=0;      // Set RS485 to Receive Mode (Low)
     EA=1;               // Enable Global Interrupts
 }
 
 /**
- * @brief Send a single byte via UART5
+ * @brief Queue a single byte via UART5
  * @param dat The byte to send.
- * @details This function blocks until transmission is complete.
+ * @details Returns immediately unless the ring is full, in which case it waits
+ *          for the TX ISR to free one slot. If the transmitter is idle it switches
+ *          the RS485 driver on and loads the first byte.
  */
 void UART5_Sendbyte(u8 dat)
 {
-    SBUF3_TX = dat;             // Load data into transmit buffer
-    while((SCON3T&0x01)==0);    // Wait for Transmit Interrupt Flag (TI)
-    SCON3T &=0xFE;              // Clear TI Flag
+    u8 next = (Tx_Head + 1) & (UART5_TX_SIZE - 1);
+
+    while(next == Tx_Tail);     // Ring full: wait for the ISR to drain one byte
+
+    Tx_Buffer[Tx_Head] = dat;
+    Tx_Head = next;
+
+    ES3T = 0;                   // Keep the ISR out while checking/starting the transmitter
+    if(!Tx_Active)
+    {
+        Tx_Active = 1;
+        RS485_TX_EN = 1;        // Enable RS485 Driver (Transmit Mode)
+        SBUF3_TX = Tx_Buffer[Tx_Tail];
+        Tx_Tail = (Tx_Tail + 1) & (UART5_TX_SIZE - 1);
+    }
+    ES3T = 1;
 }
 
 /**
- * @brief Send a string via UART5
+ * @brief Queue a string via UART5
  * @param pstr Pointer to the data buffer.
  * @param strlen Length of data to send.
- * @details Handles RS485 enable/disable switching around the transmission.
+ * @details Non-blocking while the ring has room; the RS485 driver is switched
+ *          by the transmit path itself.
  */
 void UART5_SendStr(u8 *pstr,u8 strlen)
 {
@@ -53,18 +79,50 @@ void UART5_SendStr(u8 *pstr,u8 strlen)
     {
         return;
     }
-    RS485_TX_EN=1; // Enable RS485 Driver (Transmit Mode)
     while(strlen--)
     {
         UART5_Sendbyte(*pstr);
         pstr++;
     }
-    RS485_TX_EN=0; // Disable RS485 Driver (Receive Mode)
+}
+
+/**
+ * @brief Check whether UART5 is still transmitting
+ * @return 1 while bytes are queued or on the wire, 0 when idle
+ */
+u8 UART5_TxBusy(void)
+{
+    return Tx_Active;
+}
+
+/**
+ * @brief UART5 Transmit Interrupt Service Routine
+ * @details TI is raised after the stop bit. Loads the next queued byte or, when
+ *          the ring is empty, drops RS485_TX_EN so the bus returns to receive.
+ *          Vector 13 sits next to the UART5 RX vector (14) used below.
+ */
+void UART5_TX_ISR_PC(void)    interrupt 13
+{
+    if((SCON3T&0x01)==0x01)
+    {
+        SCON3T&=0xFE;               // Clear Transmit Interrupt Flag
+        if(Tx_Tail != Tx_Head)
+        {
+            SBUF3_TX = Tx_Buffer[Tx_Tail];
+            Tx_Tail = (Tx_Tail + 1) & (UART5_TX_SIZE - 1);
+        }
+        else
+        {
+            RS485_TX_EN = 0;        // Last stop bit is out: back to Receive Mode
+            Tx_Active = 0;
+        }
+    }
 }
 
 /**
  * @brief UART5 Receive Interrupt Service Routine
- * @details Reads received byte and stores it in the circular buffer.
+ * @details Reads received byte and stores it in the circular buffer. A byte
+ *          arriving on a full ring is dropped and counted.
  */
 void UART5_RX_ISR_PC(void)    interrupt 14
 {
@@ -72,8 +130,16 @@ void UART5_RX_ISR_PC(void)    interrupt 14
     if((SCON3R&0x01)==0x01)
     {
         u8 res = SBUF3_RX;          // Read received data
-        Rx_Buffer[Rx_Head] = res;   // Store in buffer
-        Rx_Head = (Rx_Head + 1) & 0x1F; // Increment head with wrap-around (Mod 32)
+        u8 next = (Rx_Head + 1) & (UART5_RX_SIZE - 1); // Head with wrap-around
+        if(next != Rx_Tail)
+        {
+            Rx_Buffer[Rx_Head] = res;   // Store in buffer
+            Rx_Head = next;
+        }
+        else
+        {
+            Rx_Overflow++;          // Ring full: main loop fell behind
+        }
         SCON3R&=0xFE;               // Clear Receive Interrupt Flag
     }
 }
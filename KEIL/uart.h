@@ -14,6 +14,14 @@
 // RS485 Transmit Enable Pin Definition (Port 0, Pin 1)
 sbit RS485_TX_EN=P0^1;
 
+// --- Buffer Sizes (Power of 2) ---
+// The RX ring only has to hold what arrives between two drains of the main
+// loop (frames are parsed bytewise, up to 258 bytes need not fit). 256 is the
+// most a u8 index can address; bytes arriving on a full ring are dropped and
+// counted in Rx_Overflow.
+#define UART5_RX_SIZE   256     /**< Receive ring buffer size */
+#define UART5_TX_SIZE   128     /**< Transmit ring buffer size */
+
 // --- Function Prototypes ---
 
 /**
@@ -22,24 +30,38 @@ sbit RS485_TX_EN=P0^1;
 void UART5_Init(void);
 
 /**
- * @brief Send a single byte over UART5
+ * @brief Queue a single byte for UART5 transmission (non-blocking)
  * @param dat Data byte to send
  */
 void UART5_Sendbyte(u8 dat);
 
 /**
- * @brief Send a buffer of bytes over UART5
+ * @brief Queue a buffer of bytes for UART5 transmission (non-blocking)
  * @param pstr Pointer to buffer
  * @param strlen Number of bytes to send
  */
 void UART5_SendStr(u8 *pstr,u8 strlen);
 
+/**
+ * @brief Check whether UART5 is still transmitting
+ * @return 1 while bytes are queued or on the wire, 0 when idle
+ */
+u8 UART5_TxBusy(void);
+
 // --- Global External Variables ---
 /** @brief UART Receive Circular Buffer. */
-extern volatile u8 Rx_Buffer[32];
+extern volatile u8 Rx_Buffer[UART5_RX_SIZE];
 /** @brief Head index of the circular receive buffer, written by ISR. */
 extern volatile u8 Rx_Head;
 /** @brief Tail index of the circular receive buffer, read by the main loop. */
 extern volatile u8 Rx_Tail;
+/** @brief Bytes dropped because the receive ring was full (PROTO_CMD_PROF reply). */
+extern volatile u16 Rx_Overflow;
+/** @brief UART Transmit Circular Buffer, drained by the TX ISR. */
+extern volatile u8 Tx_Buffer[UART5_TX_SIZE];
+/** @brief Head index of the circular transmit buffer, written by the main loop. */
+extern volatile u8 Tx_Head;
+/** @brief Tail index of the circular transmit buffer, advanced by the TX ISR. */
+extern volatile u8 Tx_Tail;
 
 #endif
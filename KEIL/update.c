@@ -0,0 +1,290 @@
+/**
+ * @file update.c
+ * @brief Streaming Firmware/Asset Update.
+ * @details Session bookkeeping for the 0xA0-0xA4 protocol commands and a
+ *          protothread (pt.h) that verifies the staged image in small read-back
+ *          steps and then applies it, so UART, touch and the GUI keep running
+ *          until the GUI core takes over. Delta sessions run their own thread
+ *          from BEGIN on, one block behind the receiver.
+ */
+
+#include "update.h"
+#include "proto.h"
+#include "pt.h"
+#include "DWIN_GUI_VP.h"
+
+update_status Update_Status;
+
+static u8 upd_target;
+static u16 upd_crc;     // CRC16 announced in BEGIN
+static u16 upd_block;   // First flash block (UPDATE_TARGET_FLASH), file start (delta)
+static pt upd_pt;
+
+// Delta session: block list from BEGIN
+static u8 upd_idx[UPDATE_DELTA_MAX];    // Block offset from upd_block
+static u16 upd_bcrc[UPDATE_DELTA_MAX];  // CRC16 per block
+static u8 upd_count;
+static u8 upd_written;                  // Blocks verified and queued for flash
+
+// Staging buffer of the n-th streamed block (the two flash buffers alternate)
+#define DELTA_BUF(n)    (((n) & 0x01) ? FLASH_BUF1_VP : FLASH_BUF0_VP)
+
+/**
+ * @brief Check whether `list` is the block list of the open delta session.
+ */
+static u8 update_same_list(u8* list, u8 count)
+{
+    u8 i;
+
+    if(count != upd_count) return 0;
+    for(i = 0; i < count; i++)
+    {
+        if(list[i * 3] != upd_idx[i]) return 0;
+        if((((u16)list[i * 3 + 1] << 8) | list[i * 3 + 2]) != upd_bcrc[i]) return 0;
+    }
+    return 1;
+}
+
+u8 Update_Begin(u8 target, u32 bytes, u16 crc, u16 block, u8* list, u8 count)
+{
+    u8 i;
+
+    if(Update_Status.state == UPD_VERIFYING || Update_Status.state == UPD_APPLYING) return 1;
+    if(target > UPDATE_TARGET_DELTA || bytes < 2 || (bytes & 0x01)) return 1;
+    if(target == UPDATE_TARGET_DELTA)
+    {
+        // One entry per streamed block, offsets ascending
+        if(count == 0 || count > UPDATE_DELTA_MAX || bytes != (u32)count * FLASH_BLOCK_BYTES) return 1;
+        for(i = 1; i < count; i++)
+        {
+            if(list[i * 3] <= list[i * 3 - 3]) return 1;
+        }
+    }
+    else if(bytes > UPDATE_MAX_BYTES || count) return 1;
+    // VP_OS_UPDATE_CMD always copies the whole window and the flash engine
+    // writes whole blocks: nothing unchecked in what reaches flash
+    if(target == UPDATE_TARGET_CODE && bytes != UPDATE_MAX_BYTES) return 1;
+    if(target == UPDATE_TARGET_FLASH && (bytes % FLASH_BLOCK_BYTES)) return 1;
+
+    // Same image as the open session: continue where it stopped
+    if(Update_Status.state == UPD_RECEIVING && target == upd_target &&
+       bytes == Update_Status.bytes && crc == upd_crc && block == upd_block &&
+       (target != UPDATE_TARGET_DELTA || update_same_list(list, count)))
+    {
+        return 0;
+    }
+
+    // The staging window doubles as the flash engine's buffers (a timed-out
+    // block keeps them locked while idle)
+    if(!Flash_Idle() || Flash_Buffer_Used(FLASH_BUF0_VP) || Flash_Buffer_Used(FLASH_BUF1_VP)) return 1;
+
+    upd_count = count;
+    upd_written = 0;
+    for(i = 0; i < count; i++)
+    {
+        upd_idx[i] = list[i * 3];
+        upd_bcrc[i] = ((u16)list[i * 3 + 1] << 8) | list[i * 3 + 2];
+    }
+    PT_INIT(&upd_pt);
+
+    upd_target = target;
+    upd_crc = crc;
+    upd_block = block;
+    Update_Status.bytes = bytes;
+    Update_Status.next = 0;
+    Update_Status.error = UPD_ERR_NONE;
+    Update_Status.state = UPD_RECEIVING;
+    return 0;
+}
+
+u8 Update_Chunk(u16 ofs, u8* buf, u8 len)
+{
+    u16 words = len >> 1;
+    s16 back = (s16)((u16)Update_Status.next - ofs);
+    u32 pos;
+    u8 n;
+
+    if(Update_Status.state != UPD_RECEIVING || len == 0 || (len & 0x01)) return 1;
+    // Beyond the high-water mark: the host has to rewind to `next`
+    if(back < 0 || (u32)back > Update_Status.next) return 1;
+    // Full word position (chunks are never 32K words behind `next`)
+    pos = Update_Status.next - back;
+    if((pos + words) * 2 > Update_Status.bytes) return 1;
+    // Already here (the host missed our reply)
+    if(pos + words <= Update_Status.next) return 0;
+
+    if(upd_target == UPDATE_TARGET_DELTA)
+    {
+        // Within one block, whose buffer no longer holds the block before the last
+        n = (u8)(pos / FLASH_BLOCK_WORDS);
+        if((pos + words - 1) / FLASH_BLOCK_WORDS != n) return 1;
+        if(n >= upd_written + 2 || Flash_Buffer_Used(DELTA_BUF(n))) return 1;
+        write_dgus_vp(DELTA_BUF(n) + (u16)(pos % FLASH_BLOCK_WORDS), buf, len);
+    }
+    else
+    {
+        write_dgus_vp(UPDATE_STAGE_VP + (u16)pos, buf, len);
+    }
+    Update_Status.next = pos + words;
+    return 0;
+}
+
+u8 Update_Commit(void)
+{
+    if(Update_Status.state != UPD_RECEIVING) return 1;
+    if(Update_Status.next * 2 != Update_Status.bytes) return 1;
+
+    // Delta blocks are already being checked and written
+    if(upd_target == UPDATE_TARGET_DELTA)
+    {
+        Update_Status.state = UPD_APPLYING;
+        return 0;
+    }
+
+    PT_INIT(&upd_pt);
+    Update_Status.state = UPD_VERIFYING;
+    return 0;
+}
+
+u8 Update_Abort(void)
+{
+    if(Update_Status.state == UPD_APPLYING) return 1;
+    Update_Status.state = UPD_IDLE;
+    Update_Status.error = UPD_ERR_NONE;
+    Update_Status.next = 0;
+    return 0;
+}
+
+/**
+ * @brief End the session with an error; nothing has been applied.
+ */
+static void update_fail(u8 error)
+{
+    Update_Status.error = error;
+    Update_Status.state = UPD_ERROR;
+}
+
+/**
+ * @brief Verify, then apply the staged image.
+ */
+static u8 update_thread(pt* p)
+{
+    static u16 ofs;     // Word offset of the read-back
+    static u16 crc;
+    static u8 first;    // First image byte (LJMP opcode for code)
+    static u8 i;
+    u8 chunk[UPDATE_VERIFY_BYTES];
+    u8 cmd[4];
+    u16 n;
+
+    PT_BEGIN(p);
+
+    // --- 1. Read the staging window back and check the CRC ---
+    crc = 0xFFFF;
+    for(ofs = 0; (u32)ofs * 2 < Update_Status.bytes; ofs += UPDATE_VERIFY_BYTES / 2)
+    {
+        n = UPDATE_VERIFY_BYTES;
+        if((u32)ofs * 2 + n > Update_Status.bytes) n = (u16)(Update_Status.bytes - (u32)ofs * 2);
+        read_dgus_vp(UPDATE_STAGE_VP + ofs, chunk, n);
+        if(ofs == 0) first = chunk[0];
+        crc = Proto_CRC16_Add(crc, chunk, n);
+        PT_YIELD(p);
+    }
+    if(crc != upd_crc) { update_fail(UPD_ERR_CRC); PT_EXIT(p); }
+
+    // --- 2. Apply ---
+    if(upd_target == UPDATE_TARGET_CODE)
+    {
+        // Keil images start with LJMP (0x02) at the reset vector
+        if(first != 0x02) { update_fail(UPD_ERR_IMAGE); PT_EXIT(p); }
+        Update_Status.state = UPD_APPLYING;
+
+        // D3 = 0x5A enable, D2 = 0xA5 user 8051 code (64KB), D1:D0 source VP
+        cmd[0] = 0x5A;
+        cmd[1] = 0xA5;
+        cmd[2] = (u8)(UPDATE_STAGE_VP >> 8);
+        cmd[3] = (u8)UPDATE_STAGE_VP;
+        write_dgus_vp(VP_OS_UPDATE_CMD, cmd, 4);
+        PT_SLEEP(p, UPDATE_APPLY_WAIT_MS);
+
+        // System reset, the new code starts
+        cmd[0] = 0x55;
+        cmd[1] = 0xAA;
+        cmd[2] = 0x5A;
+        cmd[3] = 0xA5;
+        write_dgus_vp(VP_SYS_RESET, cmd, 4);
+        PT_WAIT_UNTIL(p, 0);
+    }
+
+    Update_Status.state = UPD_APPLYING;
+    for(i = 0; (u32)i * FLASH_BLOCK_BYTES < Update_Status.bytes; i++)
+    {
+        // A timeout ends the job and refuses further submits
+        PT_WAIT_UNTIL(p, (i && Flash_Stats.errors) ||
+                         Flash_Submit(upd_block + i, UPDATE_STAGE_VP + (u16)i * FLASH_BLOCK_WORDS) == 0);
+        if(i && Flash_Stats.errors) break;
+    }
+    PT_WAIT_UNTIL(p, Flash_Idle());
+    if(Flash_Stats.errors) { update_fail(UPD_ERR_FLASH); PT_EXIT(p); }
+    Update_Status.state = UPD_DONE;
+
+    PT_END(p);
+}
+
+/**
+ * @brief Check and write the blocks of a delta session as they arrive.
+ */
+static u8 update_delta_thread(pt* p)
+{
+    static u16 ofs;
+    static u16 crc;
+    u8 chunk[UPDATE_VERIFY_BYTES];
+
+    PT_BEGIN(p);
+
+    while(upd_written < upd_count)
+    {
+        // --- 1. Wait for the whole block ---
+        PT_WAIT_UNTIL(p, Update_Status.next >= (u32)(upd_written + 1) * FLASH_BLOCK_WORDS);
+
+        // --- 2. Read it back and check its CRC ---
+        crc = 0xFFFF;
+        for(ofs = 0; ofs < FLASH_BLOCK_WORDS; ofs += UPDATE_VERIFY_BYTES / 2)
+        {
+            read_dgus_vp(DELTA_BUF(upd_written) + ofs, chunk, UPDATE_VERIFY_BYTES);
+            crc = Proto_CRC16_Add(crc, chunk, UPDATE_VERIFY_BYTES);
+            PT_YIELD(p);
+        }
+        if(crc != upd_bcrc[upd_written]) { update_fail(UPD_ERR_CRC); PT_EXIT(p); }
+
+        // --- 3. Queue it; the other buffer keeps receiving ---
+        // (a submit on an idle engine restarts Flash_Stats, so look at errors first)
+        PT_WAIT_UNTIL(p, (upd_written && Flash_Stats.errors) ||
+                         Flash_Submit(upd_block + upd_idx[upd_written], DELTA_BUF(upd_written)) == 0);
+        if(upd_written && Flash_Stats.errors) { update_fail(UPD_ERR_FLASH); PT_EXIT(p); }
+        upd_written++;
+    }
+
+    // --- 4. Last block in flash, done once the host has sent APPLY ---
+    PT_WAIT_UNTIL(p, Flash_Idle());
+    if(Flash_Stats.errors) { update_fail(UPD_ERR_FLASH); PT_EXIT(p); }
+    PT_WAIT_UNTIL(p, Update_Status.state == UPD_APPLYING);
+    Update_Status.state = UPD_DONE;
+
+    PT_END(p);
+}
+
+void Update_Poll(void)
+{
+    if(upd_target == UPDATE_TARGET_DELTA)
+    {
+        if(Update_Status.state == UPD_RECEIVING || Update_Status.state == UPD_APPLYING)
+        {
+            update_delta_thread(&upd_pt);
+        }
+    }
+    else if(Update_Status.state == UPD_VERIFYING || Update_Status.state == UPD_APPLYING)
+    {
+        update_thread(&upd_pt);
+    }
+}
@@ -0,0 +1,122 @@
+/**
+ * @file update.h
+ * @brief Streaming Firmware/Asset Update Header File.
+ * @details Receives an image over the UART5 framed protocol (proto.h, commands
+ *          0xA0-0xA4) into a DGUS RAM staging window, verifies it and only then
+ *          hands it to the GUI core:
+ *          - UPDATE_TARGET_CODE:  VP_OS_UPDATE_CMD (0x0006, 64 KB 8051 code) and
+ *                                 VP_SYS_RESET (0x0004)
+ *          - UPDATE_TARGET_FLASH: 32 KB flash blocks through flash.h
+ *          - UPDATE_TARGET_DELTA: only the changed 32 KB blocks of a flash file
+ *                                 (TOOLS/flash_delta.py), any number of them
+ *
+ *          Chunks carry their word offset, the firmware keeps the contiguous
+ *          high-water mark (`next`). Repeated chunks are acknowledged again, a
+ *          chunk beyond `next` is refused, and every reply carries `next`, so the
+ *          host can stream without waiting and rewind to `next` after a loss.
+ *          BEGIN with the same target, size, CRC and block as the open session
+ *          resumes it instead of starting over.
+ *
+ *          Nothing is applied before the whole staging window has been read
+ *          back and its CRC16 matches the one announced in BEGIN; on any error
+ *          the running firmware and the flash stay untouched.
+ *
+ *          A delta session streams its blocks back to back through the two flash
+ *          buffers: BEGIN lists the block offsets and a CRC16 per block, every
+ *          complete block is read back, checked and queued for writing while the
+ *          next one is received. A chunk for a buffer that is still in use is
+ *          refused like a gap, which throttles the host to the flash speed. A
+ *          failed delta leaves the blocks before the bad one written; sending the
+ *          same delta again repairs the file.
+ */
+
+#ifndef __UPDATE_H__
+#define __UPDATE_H__
+
+#include "sys.h"
+#include "flash.h"
+
+// --- Configuration ---
+#define UPDATE_STAGE_VP         FLASH_BUF0_VP   /**< Staging window (VP 0x8000-0xFFFF), outside the application VPs */
+#define UPDATE_MAX_BYTES        65536UL         /**< Staging window size */
+#define UPDATE_VERIFY_BYTES     64              /**< Read back per main-loop pass */
+#define UPDATE_APPLY_WAIT_MS    1000            /**< Wait after VP_OS_UPDATE_CMD before the reset */
+#define UPDATE_DELTA_MAX        64              /**< Blocks per delta session */
+
+// --- Targets ---
+#define UPDATE_TARGET_CODE      0       /**< 8051 code (exactly 64 KB, padded by the host) */
+#define UPDATE_TARGET_FLASH     1       /**< NOR flash from a 32 KB block on, whole blocks (padded by the host) */
+#define UPDATE_TARGET_DELTA     2       /**< Listed 32 KB blocks of a flash file, written while streaming */
+
+// --- Session States ---
+#define UPD_IDLE                0
+#define UPD_RECEIVING           1
+#define UPD_VERIFYING           2
+#define UPD_APPLYING            3
+#define UPD_DONE                4
+#define UPD_ERROR               5
+
+// --- Error Codes ---
+#define UPD_ERR_NONE            0
+#define UPD_ERR_CRC             1       /**< Staged data does not match the BEGIN CRC */
+#define UPD_ERR_IMAGE           2       /**< Code image does not start with LJMP */
+#define UPD_ERR_FLASH           3       /**< A flash block write timed out */
+
+// --- Structures ---
+/**
+ * @brief Update Session Status (returned in every 0xA0-0xA4 reply)
+ */
+typedef struct _update_status
+{
+    u8 state;       // UPD_*
+    u8 error;       // UPD_ERR_*, valid in UPD_ERROR
+    u32 next;       // Words received contiguously from the start (replies carry the low 16 bits)
+    u32 bytes;      // Image size
+} update_status;
+
+// --- Global External Variables ---
+extern update_status Update_Status;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Open (or resume) an update session
+ * @param target UPDATE_TARGET_*
+ * @param bytes Image size, even, 2 .. UPDATE_MAX_BYTES (code: UPDATE_MAX_BYTES,
+ *              flash: whole FLASH_BLOCK_BYTES blocks, delta: count * FLASH_BLOCK_BYTES)
+ * @param crc CRC16 (Modbus) of the image
+ * @param block First flash block (UPDATE_TARGET_FLASH), first block of the file (delta)
+ * @param list Delta only: `count` entries IDX CRC_H CRC_L, IDX = block - `block`
+ *             (ascending), CRC = CRC16 of that block's 32 KB
+ * @param count Delta entries (0 for the other targets)
+ * @return 0 OK, 1 refused (bad arguments, apply running, flash engine busy)
+ */
+u8 Update_Begin(u8 target, u32 bytes, u16 crc, u16 block, u8* list, u8 count);
+
+/**
+ * @brief Store one chunk in the staging window
+ * @param ofs Word offset in the image (low 16 bits, the session knows the rest)
+ * @param buf Data
+ * @param len Byte count (even)
+ * @return 0 stored or already present, 1 refused (gap, overflow, no session)
+ */
+u8 Update_Chunk(u16 ofs, u8* buf, u8 len);
+
+/**
+ * @brief Start verification and, if it passes, the apply step
+ * @return 0 started, 1 refused (image incomplete or no session)
+ */
+u8 Update_Commit(void);
+
+/**
+ * @brief Drop the session (not possible while applying)
+ * @return 0 OK, 1 refused
+ */
+u8 Update_Abort(void);
+
+/**
+ * @brief Run verification/apply steps (main loop; nothing to do when idle)
+ */
+void Update_Poll(void);
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * @file vp_bind.c
+ * @brief Declarative VP Binding.
+ * @details Mirror and dirty bits are indexed like the generated table; a run's
+ *          pending words are written as the span from the first to the last
+ *          dirty word, which is a single queued write (clean words inside the
+ *          span hold the DGUS RAM value already).
+ */
+
+#include "vp_bind.h"
+#include "dgus.h"
+
+#define VPB_BIT(map, i)     ((map)[(i) >> 3] & (1 << ((i) & 0x07)))
+
+static code vpb_run vpb_runs[VPB_RUNS] = VPB_RUN_TABLE;
+static code u8 vpb_shared[(VPB_WORDS + 7) / 8] = VPB_SHARED_BITS;
+
+static u8 xdata vpb_mirror[VPB_WORDS * 2];
+static u8 xdata vpb_dirty[(VPB_WORDS + 7) / 8];
+static u8 vpb_pending = 0;
+
+void Vpb_Init(void)
+{
+    u8 r;
+
+    for(r = 0; r < VPB_RUNS; r++)
+    {
+        read_dgus_vp(vpb_runs[r].vp, &vpb_mirror[vpb_runs[r].first * 2], vpb_runs[r].words * 2);
+    }
+    for(r = 0; r < sizeof(vpb_dirty); r++) vpb_dirty[r] = 0;
+    vpb_pending = 0;
+}
+
+void Vpb_Set(u8 idx, u16 val)
+{
+    u8* m = &vpb_mirror[idx * 2];
+
+    if(m[0] == (u8)(val >> 8) && m[1] == (u8)val && !VPB_BIT(vpb_shared, idx)) return;
+
+    m[0] = (u8)(val >> 8);
+    m[1] = (u8)val;
+    vpb_dirty[idx >> 3] |= 1 << (idx & 0x07);
+    vpb_pending = 1;
+}
+
+u16 Vpb_Get(u8 idx)
+{
+    return ((u16)vpb_mirror[idx * 2] << 8) | vpb_mirror[idx * 2 + 1];
+}
+
+void Vpb_Sync(void)
+{
+    u8 r, i, lo, hi;
+    const vpb_run code* run;
+
+    if(!vpb_pending) return;
+    vpb_pending = 0;
+
+    for(r = 0; r < VPB_RUNS; r++)
+    {
+        run = &vpb_runs[r];
+        lo = 0xFF;
+        for(i = run->first; i < run->first + run->words; i++)
+        {
+            if(!VPB_BIT(vpb_dirty, i)) continue;
+            if(lo == 0xFF) lo = i;
+            hi = i;
+            vpb_dirty[i >> 3] &= ~(1 << (i & 0x07));
+        }
+        if(lo == 0xFF) continue;
+
+        // The GUI core may have changed a shared VP behind the shadow's back
+        if(run->policy != VPB_PUSH) DGUS_Shadow_Invalidate(run->vp + (lo - run->first), hi - lo + 1);
+        queue_dgus_vp(run->vp + (lo - run->first), &vpb_mirror[lo * 2], (hi - lo + 1) * 2);
+    }
+}
@@ -0,0 +1,69 @@
+/**
+ * @file vp_bind.h
+ * @brief Declarative VP Binding Header File.
+ * @details Every VP the firmware uses is declared once in TOOLS/vp_bind.cfg;
+ *          TOOLS/vp_bind.py checks it against the DGUS project and generates
+ *          vp_bind_table.h (VP_<NAME> addresses, VPB_<NAME> indices, runs).
+ *
+ *          The application sets and gets values in a RAM mirror by index.
+ *          Vpb_Sync() (once per main-loop pass) queues every changed span of a
+ *          run as one write. Values are kept big-endian in the mirror, as in
+ *          DGUS RAM. A VP the firmware has to read back (e.g. VP_BUTTON) is read
+ *          where it is used, not through the mirror.
+ *
+ *          Policies:
+ *          - VPB_PUSH   firmware owns the VP, only changed values are written
+ *          - VPB_SHARED the GUI core writes it too (touch), every set is written
+ *                       and the dgus.h shadow is not trusted for it
+ */
+
+#ifndef __VP_BIND_H__
+#define __VP_BIND_H__
+
+#include "sys.h"
+
+// --- Policies ---
+#define VPB_PUSH            0
+#define VPB_SHARED          1
+
+#include "vp_bind_table.h"
+
+// --- Structures ---
+/**
+ * @brief Run of adjacent bound VPs (one DGUS access)
+ */
+typedef struct _vpb_run
+{
+    u16 vp;         // First VP
+    u8 first;       // Mirror index of the first word
+    u8 words;       // Length
+    u8 policy;      // VPB_PUSH / VPB_SHARED
+} vpb_run;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Load the mirror from DGUS RAM (nothing pending afterwards)
+ */
+void Vpb_Init(void);
+
+/**
+ * @brief Set a bound word
+ * @param idx VPB_<NAME> (+ word offset for multi-word bindings)
+ * @param val Value
+ */
+void Vpb_Set(u8 idx, u16 val);
+
+/**
+ * @brief Get a bound word from the mirror
+ * @param idx VPB_<NAME>
+ * @return Last value set
+ */
+u16 Vpb_Get(u8 idx);
+
+/**
+ * @brief Queue all pending writes, one per run (call before flush_dgus_vp())
+ */
+void Vpb_Sync(void);
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * @file vp_bind_table.h
+ * @brief VP binding table, generated by TOOLS/vp_bind.py.
+ * @details Do not edit. Source: TOOLS/vp_bind.cfg checked against
+ *          DGUS/DWIN_SET/14ShowFile.bin and 13TouchFile.bin. Included by vp_bind.h.
+ */
+
+#ifndef __VP_BIND_TABLE_H__
+#define __VP_BIND_TABLE_H__
+
+// --- Bindings: VP address and mirror index ---
+#define VP_NTC_TEMP             0x1020  // push, page 0 display - Temperatura, cijeli stepeni
+#define VPB_NTC_TEMP            0
+#define VP_ICON_DND             0x1030  // shared, page 0 display, touch - DND ikonica (slika 00)
+#define VPB_ICON_DND            1
+#define VP_ICON_HMD             0x1040  // shared, page 0 display, touch - HMD ikonica (slika 00)
+#define VPB_ICON_HMD            2
+#define VP_HIDDEN_MENU          0x1050  // shared, page 0 display, touch - Skriveni meni (touch long press)
+#define VPB_HIDDEN_MENU         3
+#define VP_RTC_HOUR             0x1100  // push, auto
+#define VPB_RTC_HOUR            4
+#define VP_RTC_MIN              0x1101  // push, auto
+#define VPB_RTC_MIN             5
+#define VP_RTC_SEC              0x1102  // push, auto
+#define VPB_RTC_SEC             6
+#define VP_UART_DIGIT           0x1103  // push, auto - Zadnja cifra primljena preko UART5
+#define VPB_UART_DIGIT          7
+#define VP_BUTTON               0x1200  // shared, no DWIN_SET control - Tipka, GUI upisuje 1, firmware brise (cas_dgus_vp)
+#define VPB_BUTTON              8
+
+#define VPB_COUNT               9
+#define VPB_WORDS               9
+#define VPB_RUNS                6
+#define VPB_RUN_MAX             4
+
+// Runs of adjacent VPs with one policy: { VP, first index, words, policy }
+#define VPB_RUN_TABLE \
+{ \
+    { 0x1020, 0, 1, VPB_PUSH }, \
+    { 0x1030, 1, 1, VPB_SHARED }, \
+    { 0x1040, 2, 1, VPB_SHARED }, \
+    { 0x1050, 3, 1, VPB_SHARED }, \
+    { 0x1100, 4, 4, VPB_PUSH }, \
+    { 0x1200, 8, 1, VPB_SHARED } \
+}
+
+// Shared words (written on every set), one bit per mirror index
+#define VPB_SHARED_BITS         { 0x0E, 0x01 }
+
+// VPs the GUI core writes (touch controls, shared bindings): { VP, words }
+#define VPB_GUI_COUNT           5
+#define VPB_GUI_TABLE           { { 0x1000, 1 }, { 0x1030, 1 }, { 0x1040, 1 }, { 0x1050, 1 }, { 0x1200, 1 } }
+
+#endif
@@ -0,0 +1,72 @@
+/**
+ * @file fw_bench.c
+ * @brief VP Access Benchmark of the Simulator.
+ * @details Built like fw_report.c. Runs each access form BENCH_OPS times on the
+ *          bare register model and prints the simulated clocks per access: SFR
+ *          moves, APP_EN handshakes and the prof.h probes inside the EA-off
+ *          window. C instruction time is not modelled, so the work the constant
+ *          forms also save on the target (u32 address shifts, generic pointer
+ *          loads, the length loop) is not in these numbers.
+ *
+ *          Written values change on every access, so the shadow RAM lets each one
+ *          through (a dropped write costs no register access in either form); the
+ *          u32 values change in both words.
+ */
+
+#include <stdio.h>
+#include "sys.h"
+#include "dgus.h"
+
+#define BENCH_OPS       10000UL
+
+/** @brief Run `stmt` BENCH_OPS times (with `i` as the loop counter), return clocks per run. */
+#define BENCH(stmt)                                             \
+    ({                                                          \
+        unsigned long long t0_ = t5l_sim_clock();               \
+        for(i = 0; i < BENCH_OPS; i++) { stmt; }                \
+        (double)(t5l_sim_clock() - t0_) / BENCH_OPS;            \
+    })
+
+static void bench_row(const char* name, double generic, double fast)
+{
+    fprintf(stderr, "%-24s %8.1f %8.1f %7.2fx %7.1f ns\n", name, generic, fast,
+            fast > 0 ? generic / fast : 0.0, (generic - fast) * 1e9 / FOSC);
+}
+
+void t5l_sim_fw_bench(void)
+{
+    u32 i;
+    u16 w;
+    u32 d;
+    u8 buf[4];
+    double g, f;
+
+    DGUS_Shadow_Init();
+
+    fprintf(stderr, "--- VP access benchmark (%lu ops, clocks per op) --------\n", BENCH_OPS);
+    fprintf(stderr, "%-24s %8s %8s %8s %10s\n", "access", "generic", "const", "speedup", "saved/op");
+
+    g = BENCH(w = (u16)i; write_dgus_vp(0x1030, &w, 2));
+    f = BENCH(DGUS_WRITE_U16(0x1030, (u16)i));
+    bench_row("write u16, even VP", g, f);
+
+    g = BENCH(w = (u16)i; write_dgus_vp(0x1031, &w, 2));
+    f = BENCH(DGUS_WRITE_U16(0x1031, (u16)i));
+    bench_row("write u16, odd VP", g, f);
+
+    g = BENCH(d = i * 0x10001UL; write_dgus_vp(0x1040, &d, 4));
+    f = BENCH(DGUS_WRITE_U32(0x1040, i * 0x10001UL));
+    bench_row("write u32, even VP", g, f);
+
+    g = BENCH(d = i * 0x10001UL; write_dgus_vp(0x1041, &d, 4));
+    f = BENCH(DGUS_WRITE_U32(0x1041, i * 0x10001UL));
+    bench_row("write u32, odd VP", g, f);
+
+    g = BENCH(read_dgus_vp(0x0014, buf, 2));
+    f = BENCH(DGUS_READ_U16(0x0014, w));
+    bench_row("read u16, even VP", g, f);
+
+    g = BENCH(read_dgus_vp(0x1031, buf, 2));
+    f = BENCH(DGUS_READ_U16(0x1031, w));
+    bench_row("read u16, odd VP", g, f);
+}
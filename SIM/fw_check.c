@@ -0,0 +1,276 @@
+/**
+ * @file fw_check.c
+ * @brief Firmware Checks of the Simulator.
+ * @details Built like fw_report.c. Each check drives firmware functions on the
+ *          register model (only the init a check needs is done, e.g. T2_Init()
+ *          for checks that wait on Wait_Count, whose loops call t5l_sim_idle())
+ *          and compares the result with DGUS RAM or known values. `make check`
+ *          runs them all and fails if any check fails.
+ */
+
+#include <stdio.h>
+#include "sys.h"
+#include "dgus.h"
+#include "uart.h"
+#include "pt.h"
+#include "flash.h"
+#include "update.h"
+#include "DWIN_GUI_VP.h"
+
+// DWIN_PERIPHERALS.c has no header
+u8 PWM_Calc(u32 freq_hz, u8* div_ptr, u16* prec_ptr);
+u8 PWM_Set(u8 channel, u32 freq_hz, u16 duty_permille);
+
+static int check_failed;
+
+/** @brief Record one condition; prints the failing expression. */
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if(!(cond))                                                         \
+        {                                                                   \
+            fprintf(stderr, "  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            check_failed++;                                                 \
+        }                                                                   \
+    } while(0)
+
+/** @brief VP word as stored in simulated DGUS RAM. */
+static u16 dgus_word(u16 vp)
+{
+    return (t5l_sim_dgus(vp)[0] << 8) | t5l_sim_dgus(vp)[1];
+}
+
+// --- Checks ---
+
+/** A read between queue and flush must not make the shadow drop a later write. */
+static void check_shadow_queued_read(void)
+{
+    u8 one[2] = { 0x00, 0x01 };
+    u8 zero[2] = { 0x00, 0x00 };
+    u8 buf[2];
+
+    DGUS_Shadow_Init();
+    write_dgus_vp(0x1020, zero, 2);
+    queue_dgus_vp(0x1020, one, 2);
+    read_dgus_vp(0x1020, buf, 2);
+    CHECK(buf[1] == 0);
+    flush_dgus_vp();
+    CHECK(dgus_word(0x1020) == 0x0001);
+    write_dgus_vp(0x1020, zero, 2);
+    CHECK(dgus_word(0x1020) == 0x0000);
+}
+
+/** A direct write to a queued word must survive the next flush. */
+static void check_shadow_queued_write(void)
+{
+    u8 one[2] = { 0x00, 0x01 };
+    u8 two[2] = { 0x00, 0x02 };
+    u8 tail[4] = { 0x12, 0x34, 0x56, 0x78 };
+    u8 hi = 0xAB;
+
+    DGUS_Shadow_Init();
+    queue_dgus_vp(0x1020, one, 2);
+    write_dgus_vp(0x1020, two, 2);
+    flush_dgus_vp();
+    CHECK(dgus_word(0x1020) == 0x0002);
+
+    queue_dgus_vp(0x1100, one, 2);
+    DGUS_WRITE_U16(0x1100, 0x0003);
+    flush_dgus_vp();
+    CHECK(dgus_word(0x1100) == 0x0003);
+
+    // Odd length: only the high byte of the last word is replaced
+    queue_dgus_vp(0x1101, tail, 4);
+    write_dgus_vp(0x1101, &hi, 1);
+    flush_dgus_vp();
+    CHECK(dgus_word(0x1101) == 0xAB34 && dgus_word(0x1102) == 0x5678);
+}
+
+/** A word the GUI core changed must not filter a firmware write of the old value. */
+static void check_shadow_gui_write(void)
+{
+    u8 zero[2] = { 0x00, 0x00 };
+    u32 hits;
+
+    DGUS_Shadow_Init();
+    write_dgus_vp(0x1030, zero, 2);         // DND icon, a touch control writes it
+    t5l_sim_dgus(0x1030)[1] = 0x01;         // GUI core toggles the icon
+    write_dgus_vp(0x1030, zero, 2);
+    CHECK(dgus_word(0x1030) == 0x0000);
+
+    DGUS_WRITE_U16(0x1000, 0);              // Increment touch control
+    t5l_sim_dgus(0x1000)[1] = 0x05;
+    DGUS_WRITE_U16(0x1000, 0);
+    CHECK(dgus_word(0x1000) == 0x0000);
+
+    // Words only the firmware writes are still filtered
+    write_dgus_vp(0x1020, zero, 2);
+    hits = dgus_shadow_hits;
+    write_dgus_vp(0x1020, zero, 2);
+    CHECK(dgus_shadow_hits == hits + 1);
+}
+
+/** PWM_Calc() divider/precision and the registers PWM_Set() writes. */
+static void check_pwm(void)
+{
+    u8 div = 0;
+    u16 prec = 0;
+
+    // f = PWM_BASE_CLOCK / (div * prec)
+    CHECK(PWM_Calc(1000, &div, &prec) == 0 && div == 0x0D && prec == 0xF820);
+    CHECK(PWM_Calc(20000, &div, &prec) == 0 && div == 0x01 && prec == 0xA148);
+    CHECK(PWM_Calc(50, &div, &prec) == 0 && div == 0xFD && prec == 0xFEFD);
+    CHECK(PWM_Calc(49, &div, &prec) == 1);          // Divider above 255
+    CHECK(PWM_Calc(600000000UL, &div, &prec) == 1); // Precision below 2
+    CHECK(PWM_Calc(0, &div, &prec) == 1);
+
+    DGUS_Shadow_Init();
+    CHECK(PWM_Set(0, 1000, 500) == 0);
+    CHECK(dgus_word(VP_PWM0_SET) == 0x0D00 && dgus_word(VP_PWM0_SET + 1) == 0xF820);
+    CHECK(dgus_word(VP_PWM0_OUT) == 0x7C10);
+    CHECK(PWM_Set(2, 1000, 500) == 1);
+}
+
+/** Run the flash engine until it is idle (Flash_Poll() as in the main loop). */
+static void flash_run(void)
+{
+    while(!Flash_Idle()) { Flash_Poll(); t5l_sim_idle(); }
+}
+
+/** Completion path: blocks issued back to back, the queue limit, the statistics. */
+static void check_flash_done(void)
+{
+    u8 i;
+
+    T2_Init();
+    DGUS_Shadow_Init();
+
+    // One block in flight, FLASH_QUEUE_SIZE waiting
+    CHECK(Flash_Submit(0x0080, FLASH_BUF0_VP) == 0);
+    CHECK(Flash_Submit(0x0081, FLASH_BUF1_VP) == 0);
+    CHECK(Flash_Submit(0x0082, FLASH_BUF0_VP) == 0);
+    CHECK(Flash_Submit(0x0083, FLASH_BUF1_VP) == 1);
+    CHECK(Flash_Free_Buffer() == 0);
+    CHECK(dgus_word(VP_FLASH_BLOCK_WRITE) == 0x5A02 && dgus_word(VP_FLASH_BLOCK_WRITE + 1) == 0x0080);
+    flash_run();
+
+    // Simulated block time T5L_SIM_FLASH_MS (60) plus the D5:D4 settle time,
+    // seen within one poll
+    CHECK(Flash_Stats.blocks == 3 && Flash_Stats.errors == 0);
+    CHECK(Flash_Stats.block_ms_max >= 60 + FLASH_CMD_DELAY_MS &&
+          Flash_Stats.block_ms_max <= 60 + FLASH_CMD_DELAY_MS + FLASH_POLL_MS + 1);
+    CHECK(Flash_Stats.busy_ms <= 3 * (60 + FLASH_CMD_DELAY_MS + FLASH_POLL_MS + 1));
+    CHECK(dgus_word(VP_FLASH_BLOCK_WRITE + 3) == FLASH_CMD_DELAY_MS);
+    CHECK((dgus_word(VP_FLASH_BLOCK_WRITE) >> 8) == 0x00);
+    CHECK(dgus_word(VP_FLASH_BLOCK_WRITE + 1) == 0x0082);
+    CHECK(Flash_Free_Buffer() == FLASH_BUF0_VP);
+
+    // A submit on the idle engine starts a new job
+    for(i = 0; i < 2; i++) CHECK(Flash_Submit(0x0090 + i, FLASH_BUF1_VP) == 0);
+    flash_run();
+    CHECK(Flash_Stats.blocks == 2 && Flash_Stats.errors == 0);
+}
+
+/** Timeout path: a block whose enable byte never clears ends the job, nothing is issued over it. */
+static void check_flash_timeout(void)
+{
+    u16 t0;
+
+    T2_Init();
+    DGUS_Shadow_Init();
+
+    CHECK(Flash_Submit(0x0080, FLASH_BUF0_VP) == 0);
+    CHECK(Flash_Submit(0x0081, FLASH_BUF1_VP) == 0);
+    t0 = Wait_Count;
+    // The GUI core never finishes the first block
+    while(Flash_Stats.errors == 0 && !Flash_Idle())
+    {
+        t5l_sim_dgus(VP_FLASH_BLOCK_WRITE)[0] = 0x5A;
+        Flash_Poll();
+        t5l_sim_idle();
+    }
+    CHECK(Flash_Stats.errors == 1 && Flash_Stats.blocks == 0);
+    CHECK(Flash_Stats.block_ms_last >= FLASH_TIMEOUT_MS &&
+          Flash_Stats.block_ms_last <= FLASH_TIMEOUT_MS + FLASH_POLL_MS + 1);
+    CHECK((u16)(Wait_Count - t0) >= FLASH_TIMEOUT_MS);
+
+    // The queue is dropped, the command and both buffers stay with the GUI core
+    CHECK(Flash_Idle() && dgus_word(VP_FLASH_BLOCK_WRITE + 1) == 0x0080);
+    CHECK(Flash_Free_Buffer() == 0);
+    CHECK(Flash_Submit(0x0082, FLASH_BUF1_VP) == 1);
+    t0 = Wait_Count;
+    while((u16)(Wait_Count - t0) < 10 * FLASH_POLL_MS) { Flash_Poll(); t5l_sim_idle(); }
+    CHECK(Flash_Free_Buffer() == 0 && (dgus_word(VP_FLASH_BLOCK_WRITE) >> 8) == 0x5A);
+    CHECK(Flash_Stats.errors == 1 && Flash_Stats.blocks == 0);
+
+    // Released once the GUI core clears the enable byte
+    t5l_sim_dgus(VP_FLASH_BLOCK_WRITE)[0] = 0x00;
+    t0 = Wait_Count;
+    while((u16)(Wait_Count - t0) <= FLASH_POLL_MS) { Flash_Poll(); t5l_sim_idle(); }
+    CHECK(Flash_Free_Buffer() == FLASH_BUF0_VP);
+    CHECK(Flash_Submit(0x0082, FLASH_BUF1_VP) == 0);
+    flash_run();
+    CHECK(Flash_Stats.errors == 0 && Flash_Stats.blocks == 1);
+}
+
+/** Test_Flash_Write_Full_16ICL() to the end; prints its Flash_Report() line. */
+static void check_flash_16icl(void)
+{
+    pt p;
+
+    T2_Init();
+    UART5_Init();
+    DGUS_Shadow_Init();
+
+    PT_INIT(&p);
+    while(Test_Flash_Write_Full_16ICL(&p) != PT_ENDED) { Flash_Poll(); t5l_sim_idle(); }
+    while(UART5_TxBusy()) t5l_sim_idle();
+    fflush(stdout);
+
+    CHECK(Flash_Stats.blocks == 8 && Flash_Stats.errors == 0);
+    CHECK(dgus_word(VP_FLASH_BLOCK_WRITE + 1) == 0x0087);
+}
+
+/** A code image is the whole 64 KB window VP_OS_UPDATE_CMD copies, a flash image whole blocks. */
+static void check_update_code_size(void)
+{
+    CHECK(Update_Begin(UPDATE_TARGET_CODE, 1024, 0, 0, NULL, 0) == 1);
+    CHECK(Update_Begin(UPDATE_TARGET_CODE, UPDATE_MAX_BYTES - 2, 0, 0, NULL, 0) == 1);
+    CHECK(Update_Begin(UPDATE_TARGET_CODE, UPDATE_MAX_BYTES, 0, 0, NULL, 0) == 0);
+    CHECK(Update_Abort() == 0);
+    // The flash engine writes whole blocks: a short tail would go out unchecked
+    CHECK(Update_Begin(UPDATE_TARGET_FLASH, 1024, 0, 0x80, NULL, 0) == 1);
+    CHECK(Update_Begin(UPDATE_TARGET_FLASH, FLASH_BLOCK_BYTES + 2, 0, 0x80, NULL, 0) == 1);
+    CHECK(Update_Begin(UPDATE_TARGET_FLASH, FLASH_BLOCK_BYTES, 0, 0x80, NULL, 0) == 0);
+    CHECK(Update_Abort() == 0);
+}
+
+static const struct
+{
+    const char* name;
+    void (*run)(void);
+} checks[] = {
+    { "shadow: read with a queued write", check_shadow_queued_read },
+    { "shadow: direct write to a queued word", check_shadow_queued_write },
+    { "shadow: GUI-written word", check_shadow_gui_write },
+    { "pwm: PWM_Calc and PWM_Set registers", check_pwm },
+    { "flash: blocks complete, queue limit", check_flash_done },
+    { "flash: block timeout", check_flash_timeout },
+    { "flash: 16.icl test job", check_flash_16icl },
+    { "update: code and flash image size", check_update_code_size },
+};
+
+int t5l_sim_fw_check(void)
+{
+    unsigned i;
+    int total = 0;
+
+    fprintf(stderr, "--- firmware checks ---------------------------------------\n");
+    for(i = 0; i < sizeof(checks) / sizeof(checks[0]); i++)
+    {
+        check_failed = 0;
+        checks[i].run();
+        fprintf(stderr, "%-40s %s\n", checks[i].name, check_failed ? "FAIL" : "ok");
+        total += check_failed;
+    }
+    return total;
+}
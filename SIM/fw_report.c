@@ -0,0 +1,38 @@
+/**
+ * @file fw_report.c
+ * @brief Firmware Statistics Section of the Simulator Report.
+ * @details Built like a firmware file (t5l_sim.h force-included, generated
+ *          headers) but not part of the Keil project. Prints the prof.h
+ *          statistics the firmware collected, converted to microseconds.
+ */
+
+#include <stdio.h>
+#include "sys.h"
+#include "prof.h"
+#include "sched.h"
+#include "uart.h"
+
+/** @brief Timer 2 counts to microseconds. */
+static double fw_us(u32 counts)
+{
+    return counts * 12.0 * 1e6 / FOSC;
+}
+
+void t5l_sim_fw_report(void)
+{
+    static const char* names[PROF_SITES] = {
+        "loop pass", "ea-off (all)", "read_dgus_vp", "write_dgus_vp", "flush_dgus_vp",
+        "page switch", "rmw_dgus_vp"
+    };
+    u8 i;
+
+    fprintf(stderr, "--- firmware prof.h (Timer 2 stamps) ---------------------\n");
+    for(i = 0; i < PROF_SITES; i++)
+    {
+        prof_stat* s = &Prof_Stats[i];
+        fprintf(stderr, "%-19s %lu, max %.2f us, avg %.2f us\n", names[i],
+                (unsigned long)s->count, fw_us(s->max),
+                s->count ? fw_us(s->total) / s->count : 0.0);
+    }
+    fprintf(stderr, "%-19s %u\n", "uart5 rx overflow", (unsigned)Rx_Overflow);
+}
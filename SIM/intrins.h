@@ -0,0 +1,15 @@
+/**
+ * @file intrins.h
+ * @brief Host-side replacement for the Keil C51 intrinsic functions.
+ */
+
+#ifndef __INTRINS_H__
+#define __INTRINS_H__
+
+#define _nop_()         ((void)0)
+#define _crol_(c, n)    ((unsigned char)(((c) << ((n) & 7)) | ((c) >> ((8 - ((n) & 7)) & 7))))
+#define _cror_(c, n)    ((unsigned char)(((c) >> ((n) & 7)) | ((c) << ((8 - ((n) & 7)) & 7))))
+#define _irol_(i, n)    ((unsigned short)(((i) << ((n) & 15)) | ((i) >> ((16 - ((n) & 15)) & 15))))
+#define _iror_(i, n)    ((unsigned short)(((i) >> ((n) & 15)) | ((i) << ((16 - ((n) & 15)) & 15))))
+
+#endif
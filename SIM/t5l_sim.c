@@ -0,0 +1,752 @@
+/**
+ * @file t5l_sim.c
+ * @brief Host-side T5L Register Layer Simulator Core.
+ * @details Implements the SFR file, the DGUS RAM access engine, Timer 0/1/2,
+ *          UART5 and interrupt dispatch behind the accessors of t5l_sim.h.
+ *
+ *          Bit-addressable SFRs (addresses 0x80, 0x88 ... 0xF8) keep their state
+ *          in eight bit cells; a byte access hands out a mirror byte that is folded
+ *          back into the cells on the next register access if the firmware wrote it.
+ *
+ *          Run-time control (environment):
+ *          - T5L_SIM_MS      Simulated run time in ms (default 10000)
+ *          - T5L_SIM_RX      Bytes injected into UART5 RX (C escapes \r \n \xHH)
+ *          - T5L_SIM_RX_FILE Binary file injected into UART5 RX after T5L_SIM_RX
+ *          - T5L_SIM_RX_AT   Time of the first injected byte in ms (default 100)
+ *          - T5L_SIM_ADC     Raw value loaded into AD0-AD7 (default 0x8080)
+ *          - T5L_SIM_DUMP    VP range listed in the report, "vp,words" (e.g. 0x1000,0x60)
+ *          - T5L_SIM_TOUCH   One touch on VP_TP_STATUS, "from_ms,to_ms,x,y"
+ *          - T5L_SIM_FLASH_MS GUI core time per 32 KB flash block write (default 60)
+ *          - T5L_SIM_PAGE_MS GUI core time from VP_PIC_SET to VP_PIC_NOW (default 15)
+ *          - T5L_SIM_BENCH   Run the fw_bench.c VP access benchmark instead of the firmware
+ *          - T5L_SIM_CHECK   Run the fw_check.c checks instead of the firmware (exit 1 on failure)
+ *
+ *          UART5 output goes to stdout, the run report to stderr.
+ */
+
+#define T5L_SIM_CORE
+#include "t5l_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+typedef unsigned char       u8;
+typedef unsigned short      u16;
+typedef unsigned long long  u64;
+
+// --- Timing Model ---
+#define SIM_FOSC            206438400ULL
+#define SIM_CLK_PER_MS      (SIM_FOSC / 1000)
+#define SIM_CLK_SFR         2       // One SFR move on the 1T core
+#define SIM_CLK_DGUS        24      // APP_EN handshake with the GUI core
+#define SIM_CLK_ISR         12      // Vectoring, context push and RETI
+#define SIM_NEVER           (~0ULL)
+
+// --- DGUS RAM (64K VP words) ---
+#define SIM_DGUS_WORDS      0x10000UL
+#define SIM_OS_ADDR_MASK    0x7FFFUL
+
+// --- SFR Addresses Used by the Core ---
+#define A_P0        0x80
+#define A_TCON      0x88
+#define A_TL0       0x8A
+#define A_TL1       0x8B
+#define A_TH0       0x8C
+#define A_TH1       0x8D
+#define A_SCON3T    0xA7
+#define A_IEN0      0xA8
+#define A_SCON3R    0xAB
+#define A_SBUF3_TX  0xAC
+#define A_SBUF3_RX  0xAD
+#define A_BODE3_H   0xAE
+#define A_BODE3_L   0xAF
+#define A_IEN1      0xB8
+#define A_IRCON     0xC0
+#define A_T2CON     0xC8
+#define A_TRL2L     0xCA
+#define A_TRL2H     0xCB
+#define A_TL2       0xCC
+#define A_TH2       0xCD
+#define A_ADR_H     0xF1
+#define A_ADR_M     0xF2
+#define A_ADR_L     0xF3
+#define A_ADR_INC   0xF4
+#define A_RAMMODE   0xF8
+#define A_DATA3     0xFA
+
+#define IS_BITADDR(a)   (((a) & 0x07) == 0)
+#define CELL(a, n)      bit_cell[((a) - 0x80) >> 3][n]
+
+// --- Core State ---
+static volatile u8 sfr[256];
+static u8 sfr_snap[256];
+static volatile u8 bit_cell[16][8];
+static u8 dgus_ram[SIM_DGUS_WORDS * 2];
+static void (*vectors[32])(void);
+
+static u64 now = 1;
+static u64 end_clk;
+static u8 in_isr = 0;
+
+static u64 t0_next = SIM_NEVER, t1_next = SIM_NEVER, t2_next = SIM_NEVER;
+
+static u8 tx_armed = 0;
+static u64 tx_done = SIM_NEVER;
+static u8 tx_byte;
+static u8 tx_truncated = 0;
+
+static u8* rx_queue;
+static size_t rx_len = 0, rx_pos = 0, rx_cap = 0;
+static u64 rx_next = SIM_NEVER;
+
+// Scripted touch: status 0x01 (press), 0x03 (held) one ms later, 0x02 (release)
+static u64 touch_at[3] = { SIM_NEVER, SIM_NEVER, SIM_NEVER };
+static u8 touch_pos[4];
+static u8 touch_step = 0;
+
+static u8 ea_last = 0;
+static u64 ea_off_at = 0;
+
+// Page switch: VP_PIC_NOW follows VP_PIC_SET after the page is drawn
+static u64 page_done = SIM_NEVER;
+static u64 page_clk;
+
+// Flash block write on VP 0x00AA: the enable byte clears when it is done
+static u64 flash_done = SIM_NEVER;
+static u64 flash_block_clk;
+
+// --- Statistics ---
+static struct
+{
+    u64 sfr_access;
+    u64 dgus_read;
+    u64 dgus_write;
+    u64 ea_off_count;
+    u64 ea_off_clk;
+    u64 ea_off_max;
+    u64 idle_clk;
+    u64 isr_count[32];
+    u64 isr_clk[32];
+    u64 uart_tx;
+    u64 uart_rx;
+    u64 rs485_truncated;
+    u64 page_switch;
+    u64 flash_blocks;
+    u64 os_update;
+    u64 sys_reset;
+} stat;
+
+static u64 idle_mark = ~0ULL;
+/** @brief Set on every register access and idle call, cleared by the watchdog signal. */
+static volatile sig_atomic_t sim_alive = 1;
+static u8 in_check;     // fw_check.c running: the end of time is a failure
+
+static void sim_step(void);
+
+/**
+ * @brief Compose a bit-addressable SFR byte from its bit cells.
+ */
+static u8 compose(u8 a)
+{
+    u8 n, v = 0;
+    for(n = 0; n < 8; n++) if(CELL(a, n)) v |= (u8)(1 << n);
+    return v;
+}
+
+/**
+ * @brief Scatter a byte into the bit cells of a bit-addressable SFR.
+ */
+static void scatter(u8 a, u8 v)
+{
+    u8 n;
+    for(n = 0; n < 8; n++) CELL(a, n) = (v >> n) & 0x01;
+}
+
+/**
+ * @brief Fold firmware writes made through byte mirrors back into the bit cells.
+ */
+static void fold_mirrors(void)
+{
+    unsigned a;
+    for(a = 0x80; a <= 0xF8; a += 8)
+    {
+        if(sfr[a] != sfr_snap[a])
+        {
+            scatter((u8)a, sfr[a]);
+            sfr_snap[a] = sfr[a];
+        }
+    }
+}
+
+// =============================================================================
+//  DGUS RAM ACCESS ENGINE
+// =============================================================================
+
+/**
+ * @brief Minimal GUI core model: react to command VPs written by the OS core.
+ * @param vp First VP word of the 32-bit OS word that was written
+ */
+static void gui_post_write(unsigned long vp)
+{
+    u8* pic_set = &dgus_ram[0x0084 * 2];
+
+    // VP_PIC_SET (0x0084): 0x5A01 + page id -> VP_PIC_NOW (0x0014) once drawn
+    if(vp == 0x0084 && pic_set[0] == 0x5A && pic_set[1] == 0x01 && page_done == SIM_NEVER)
+    {
+        page_done = now + page_clk;
+    }
+
+    // VP_OS_UPDATE_CMD (0x0006): 0x5AA5 + source VP, accepted and released at once
+    if(vp == 0x0006 && dgus_ram[0x0006 * 2] == 0x5A && dgus_ram[0x0006 * 2 + 1] == 0xA5)
+    {
+        dgus_ram[0x0006 * 2] = 0x00;
+        stat.os_update++;
+    }
+
+    // VP_SYS_RESET (0x0004): 55 AA 5A A5 (the simulated firmware keeps running)
+    if(vp == 0x0004 && dgus_ram[0x0004 * 2] == 0x55 && dgus_ram[0x0004 * 2 + 1] == 0xAA &&
+       dgus_ram[0x0004 * 2 + 2] == 0x5A && dgus_ram[0x0004 * 2 + 3] == 0xA5)
+    {
+        memset(&dgus_ram[0x0004 * 2], 0, 4);
+        stat.sys_reset++;
+    }
+
+    // VP 0x00AA: 0x5A02 + block + source + delay -> busy for a block write time
+    if(vp == 0x00AA && dgus_ram[0x00AA * 2] == 0x5A && dgus_ram[0x00AA * 2 + 1] == 0x02 &&
+       flash_done == SIM_NEVER)
+    {
+        flash_done = now + flash_block_clk;
+    }
+}
+
+/**
+ * @brief Execute one APP_EN transaction on the 32-bit OS word at ADR_H/M/L.
+ */
+static void dgus_transaction(void)
+{
+    unsigned long os_addr = ((unsigned long)sfr[A_ADR_H] << 16) |
+                            ((unsigned long)sfr[A_ADR_M] << 8) | sfr[A_ADR_L];
+    u8* word = &dgus_ram[(os_addr & SIM_OS_ADDR_MASK) * 4];
+    u8 mode = compose(A_RAMMODE);
+    u8 n;
+
+    if(mode & 0x20)
+    {
+        // Read: DATA3..DATA0 <- OS word (byte enables ignored, as on the ASIC)
+        for(n = 0; n < 4; n++) sfr[A_DATA3 + n] = word[n];
+        stat.dgus_read++;
+    }
+    else
+    {
+        for(n = 0; n < 4; n++)
+        {
+            if(mode & (0x08 >> n)) word[n] = sfr[A_DATA3 + n];
+        }
+        stat.dgus_write++;
+        gui_post_write((os_addr & SIM_OS_ADDR_MASK) * 2);
+    }
+
+    os_addr += sfr[A_ADR_INC];
+    sfr[A_ADR_H] = (u8)(os_addr >> 16);
+    sfr[A_ADR_M] = (u8)(os_addr >> 8);
+    sfr[A_ADR_L] = (u8)os_addr;
+
+    CELL(A_RAMMODE, 6) = 0; // APP_EN self-clears when the GUI core is done
+    now += SIM_CLK_DGUS;
+}
+
+// =============================================================================
+//  TIMERS, UART5 AND INTERRUPTS
+// =============================================================================
+
+/** @brief Clocks until overflow of a 16-bit mode 1 timer counting at FOSC/12. */
+static u64 t01_period(u8 th, u8 tl)
+{
+    return (65536ULL - (((u16)th << 8) | tl)) * 12;
+}
+
+/** @brief Clocks per Timer 2 auto-reload period. */
+static u64 t2_period(void)
+{
+    u64 div = CELL(A_T2CON, 7) ? 24 : 12;
+    return (65536ULL - (((u16)sfr[A_TRL2H] << 8) | sfr[A_TRL2L])) * div;
+}
+
+/** @brief Clocks per UART5 character (start + 8 data + stop). */
+static u64 uart5_char_clk(void)
+{
+    u64 div = ((u16)sfr[A_BODE3_H] << 8) | sfr[A_BODE3_L];
+    if(div == 0) div = 1;
+    return div * 8 * 10;
+}
+
+/**
+ * @brief Start/stop timers according to their run bits.
+ */
+static void timers_sync(void)
+{
+    if(CELL(A_TCON, 4)) { if(t0_next == SIM_NEVER) t0_next = now + t01_period(sfr[A_TH0], sfr[A_TL0]); }
+    else t0_next = SIM_NEVER;
+
+    if(CELL(A_TCON, 6)) { if(t1_next == SIM_NEVER) t1_next = now + t01_period(sfr[A_TH1], sfr[A_TL1]); }
+    else t1_next = SIM_NEVER;
+
+    if(CELL(A_T2CON, 0)) { if(t2_next == SIM_NEVER) t2_next = now + t2_period(); }
+    else t2_next = SIM_NEVER;
+}
+
+/**
+ * @brief Vector ready for service, or -1.
+ * @details Fixed priority order, lowest interrupt number first.
+ */
+static int ready_vector(void)
+{
+    if(CELL(A_TCON, 5) && CELL(A_IEN0, 1) && vectors[1]) return 1;
+    if(CELL(A_TCON, 7) && CELL(A_IEN0, 3) && vectors[3]) return 3;
+    if(CELL(A_IRCON, 6) && CELL(A_IEN0, 5) && vectors[5]) return 5;
+    if((sfr[A_SCON3T] & 0x01) && CELL(A_IEN1, 4) && vectors[13]) return 13;
+    if((sfr[A_SCON3R] & 0x01) && CELL(A_IEN1, 5) && vectors[14]) return 14;
+    return -1;
+}
+
+/**
+ * @brief Run pending ISRs while EA is set (no nesting, single priority level).
+ */
+static void dispatch(void)
+{
+    int v;
+    u64 t;
+
+    if(in_isr || !CELL(A_IEN0, 7)) return;
+
+    while((v = ready_vector()) >= 0)
+    {
+        if(v == 1) CELL(A_TCON, 5) = 0; // TF0/TF1 are cleared by hardware on vectoring
+        if(v == 3) CELL(A_TCON, 7) = 0;
+
+        in_isr = 1;
+        t = now;
+        now += SIM_CLK_ISR;
+        vectors[v]();
+        fold_mirrors();
+        in_isr = 0;
+        stat.isr_count[v]++;
+        stat.isr_clk[v] += now - t;
+
+        // Mode 1 timers restart counting from the value the ISR reloaded
+        if(v == 1 && CELL(A_TCON, 4)) t0_next = now + t01_period(sfr[A_TH0], sfr[A_TL0]);
+        if(v == 3 && CELL(A_TCON, 6)) t1_next = now + t01_period(sfr[A_TH1], sfr[A_TL1]);
+    }
+}
+
+/** @brief Earliest scheduled hardware event. */
+static u64 next_event(void)
+{
+    u64 t = end_clk;
+    if(t0_next < t) t = t0_next;
+    if(t1_next < t) t = t1_next;
+    if(t2_next < t) t = t2_next;
+    if(tx_done < t) t = tx_done;
+    if(rx_next < t) t = rx_next;
+    if(touch_step < 3 && touch_at[touch_step] < t) t = touch_at[touch_step];
+    if(flash_done < t) t = flash_done;
+    if(page_done < t) t = page_done;
+    return t;
+}
+
+static void sim_report(void);
+
+/**
+ * @brief Process all hardware events up to the current time, then dispatch ISRs.
+ */
+static void run_events(void)
+{
+    u64 t;
+
+    timers_sync();
+
+    while((t = next_event()) <= now)
+    {
+        if(t >= end_clk)
+        {
+            if(in_check)
+            {
+                fprintf(stderr, "check still running at T5L_SIM_MS\n");
+                exit(1);
+            }
+            sim_report();
+            exit(0);
+        }
+        if(t == t0_next) { CELL(A_TCON, 5) = 1; t0_next = t + 65536ULL * 12; }
+        if(t == t1_next) { CELL(A_TCON, 7) = 1; t1_next = t + 65536ULL * 12; }
+        if(t == t2_next) { CELL(A_IRCON, 6) = 1; t2_next = t + t2_period(); }
+        if(t == tx_done)
+        {
+            if(tx_truncated) stat.rs485_truncated++;
+            putchar(tx_byte);
+            stat.uart_tx++;
+            sfr[A_SCON3T] |= 0x01; // TI
+            tx_done = SIM_NEVER;
+        }
+        if(t == rx_next)
+        {
+            sfr[A_SBUF3_RX] = rx_queue[rx_pos++];
+            sfr[A_SCON3R] |= 0x01; // RI
+            stat.uart_rx++;
+            rx_next = (rx_pos < rx_len) ? t + uart5_char_clk() : SIM_NEVER;
+        }
+        if(touch_step < 3 && t == touch_at[touch_step])
+        {
+            static const u8 status[3] = { 0x01, 0x03, 0x02 };
+            u8* tp = &dgus_ram[0x0016 * 2];
+            tp[0] = 0x5A;
+            tp[1] = status[touch_step++];
+            memcpy(&tp[2], touch_pos, 4);
+        }
+        if(t == page_done)
+        {
+            u8* pic_set = &dgus_ram[0x0084 * 2];
+            dgus_ram[0x0014 * 2] = pic_set[2];
+            dgus_ram[0x0014 * 2 + 1] = pic_set[3];
+            pic_set[0] = 0x00;
+            stat.page_switch++;
+            page_done = SIM_NEVER;
+        }
+        if(t == flash_done)
+        {
+            // D5:D4 asks the GUI core to wait before it releases the command
+            u8* cmd = &dgus_ram[0x00AA * 2];
+            u64 wait = SIM_CLK_PER_MS * (u64)((cmd[6] << 8) | cmd[7]);
+            if(wait && cmd[0] == 0x5A && cmd[1] == 0x02)
+            {
+                cmd[1] = 0x00;
+                flash_done = t + wait;
+            }
+            else
+            {
+                cmd[0] = 0x00;
+                stat.flash_blocks++;
+                flash_done = SIM_NEVER;
+            }
+        }
+    }
+
+    dispatch();
+}
+
+/**
+ * @brief Advance the simulator by one register access.
+ */
+static void sim_step(void)
+{
+    u8 ea;
+
+    sim_alive = 1;
+    stat.sfr_access++;
+    fold_mirrors();
+
+    if(tx_armed)
+    {
+        tx_armed = 0;
+        tx_byte = sfr[A_SBUF3_TX];
+        tx_truncated = 0;
+        tx_done = now + uart5_char_clk();
+    }
+    if(tx_done != SIM_NEVER && !CELL(A_P0, 1)) tx_truncated = 1; // RS485 driver off mid-character
+
+    if(CELL(A_RAMMODE, 6)) dgus_transaction();
+
+    // EA-off window tracking (outside ISRs)
+    ea = CELL(A_IEN0, 7);
+    if(!in_isr && ea != ea_last)
+    {
+        if(!ea) ea_off_at = now;
+        else
+        {
+            u64 w = now - ea_off_at;
+            stat.ea_off_count++;
+            stat.ea_off_clk += w;
+            if(w > stat.ea_off_max) stat.ea_off_max = w;
+        }
+        ea_last = ea;
+    }
+
+    now += SIM_CLK_SFR;
+    run_events();
+}
+
+// =============================================================================
+//  ACCESSORS (t5l_sim.h)
+// =============================================================================
+
+/**
+ * @brief Load the running count of a timer into the accessed TH/TL byte.
+ * @details Only the accessed byte is updated, so an ISR reloading TH then TL
+ *          does not see its TH write overwritten by the TL access. All three
+ *          timers count up and overflow at 65536, so the count follows from the
+ *          time left to the next overflow.
+ * @param addr A_THx or A_TLx of Timer 0, 1 or 2
+ */
+static void timer_live(u8 addr)
+{
+    u64 next, div = 12;
+    u16 count;
+
+    if(addr == A_TH0 || addr == A_TL0) next = t0_next;
+    else if(addr == A_TH1 || addr == A_TL1) next = t1_next;
+    else { next = t2_next; div = CELL(A_T2CON, 7) ? 24 : 12; }
+
+    if(next == SIM_NEVER || next < now) return;
+    count = (u16)(65536ULL - (next - now + div - 1) / div);
+    sfr[addr] = (addr == A_TH0 || addr == A_TH1 || addr == A_TH2) ? (u8)(count >> 8) : (u8)count;
+}
+
+volatile unsigned char* t5l_sim_sfr(unsigned char addr)
+{
+    sim_step();
+    if((addr >= A_TL0 && addr <= A_TH1) || addr == A_TL2 || addr == A_TH2) timer_live(addr);
+    if(IS_BITADDR(addr))
+    {
+        sfr[addr] = compose(addr);
+        sfr_snap[addr] = sfr[addr];
+    }
+    if(addr == A_SBUF3_TX) tx_armed = 1;
+    return &sfr[addr];
+}
+
+volatile unsigned char* t5l_sim_bit(unsigned char addr, unsigned char n)
+{
+    sim_step();
+    return &CELL(addr, n & 0x07);
+}
+
+void t5l_sim_set_vector(unsigned char vector, void (*isr)(void))
+{
+    vectors[vector & 0x1F] = isr;
+}
+
+unsigned long long t5l_sim_clock(void)
+{
+    return now;
+}
+
+unsigned char* t5l_sim_dgus(unsigned long vp)
+{
+    return &dgus_ram[(vp % SIM_DGUS_WORDS) * 2];
+}
+
+// =============================================================================
+//  IDLE FAST-FORWARD, SETUP AND REPORT
+// =============================================================================
+
+void t5l_sim_idle(void)
+{
+    u64 t;
+
+    sim_alive = 1;
+    if(in_isr) return;
+
+    // A pass with register accesses did real work, only an empty one waits
+    if(stat.sfr_access == idle_mark)
+    {
+        fold_mirrors();
+        t = next_event();
+        if(t > now)
+        {
+            stat.idle_clk += t - now;
+            now = t;
+        }
+        run_events();
+    }
+    idle_mark = stat.sfr_access;
+}
+
+/**
+ * @brief Host watchdog signal: stop a run that makes no progress.
+ * @details A busy-wait without register access that keil2gcc.sed did not
+ *          rewrite would hang the host. Only async-signal-safe calls here; the
+ *          simulation itself never runs from the signal.
+ */
+static void sim_alarm(int sig)
+{
+    static const char msg[] = "t5l-sim: no register access for 2 s, firmware busy-wait without t5l_sim_idle()\n";
+    ssize_t r;
+    (void)sig;
+
+    if(!sim_alive)
+    {
+        r = write(2, msg, sizeof(msg) - 1);
+        (void)r;
+        _exit(2);
+    }
+    sim_alive = 0;
+}
+
+/** @brief Append one byte to the RX queue. */
+static void rx_put(u8 c)
+{
+    if(rx_len == rx_cap)
+    {
+        rx_cap = rx_cap ? rx_cap * 2 : 256;
+        rx_queue = realloc(rx_queue, rx_cap);
+    }
+    rx_queue[rx_len++] = c;
+}
+
+/** @brief Parse T5L_SIM_RX escapes into the RX queue. */
+static void rx_load(const char* s)
+{
+    while(*s)
+    {
+        u8 c = (u8)*s++;
+        if(c == '\\' && *s)
+        {
+            c = (u8)*s++;
+            if(c == 'r') c = '\r';
+            else if(c == 'n') c = '\n';
+            else if(c == 'x') { c = (u8)strtoul(s, (char**)&s, 16); }
+        }
+        rx_put(c);
+    }
+}
+
+/** @brief Append the contents of T5L_SIM_RX_FILE to the RX queue. */
+static void rx_load_file(const char* path)
+{
+    FILE* f = fopen(path, "rb");
+    int c;
+
+    if(!f)
+    {
+        fprintf(stderr, "t5l_sim: cannot open %s\n", path);
+        exit(1);
+    }
+    while((c = fgetc(f)) != EOF) rx_put((u8)c);
+    fclose(f);
+}
+
+static double clk_us(u64 clk)
+{
+    return (double)clk * 1e6 / (double)SIM_FOSC;
+}
+
+static void sim_report(void)
+{
+    static const struct { u8 vec; const char* name; } isr_names[] = {
+        { 1, "T0" }, { 3, "T1" }, { 5, "T2" }, { 13, "UART5 TX" }, { 14, "UART5 RX" }
+    };
+    u64 isr_total = 0;
+    const char* s;
+    unsigned long i;
+
+    fflush(stdout);
+    for(i = 0; i < 32; i++) isr_total += stat.isr_clk[i];
+
+    fprintf(stderr, "\n--- t5l-sim report ---------------------------------------\n");
+    fprintf(stderr, "simulated time      %.3f ms (%llu clk, %.1f%% idle fast-forward)\n",
+            clk_us(now) / 1000.0, now, 100.0 * stat.idle_clk / now);
+    fprintf(stderr, "sfr accesses        %llu\n", stat.sfr_access);
+    fprintf(stderr, "dgus transactions   %llu read, %llu write\n", stat.dgus_read, stat.dgus_write);
+    fprintf(stderr, "ea-off windows      %llu, max %.2f us, avg %.2f us, %.2f%% of time\n",
+            stat.ea_off_count, clk_us(stat.ea_off_max),
+            stat.ea_off_count ? clk_us(stat.ea_off_clk) / stat.ea_off_count : 0.0,
+            100.0 * stat.ea_off_clk / now);
+    for(i = 0; i < sizeof(isr_names) / sizeof(isr_names[0]); i++)
+    {
+        u8 v = isr_names[i].vec;
+        if(!stat.isr_count[v]) continue;
+        fprintf(stderr, "isr %-15s %llu calls, avg %.2f us\n", isr_names[i].name,
+                stat.isr_count[v], clk_us(stat.isr_clk[v]) / stat.isr_count[v]);
+    }
+    fprintf(stderr, "isr load            %.2f%%\n", 100.0 * isr_total / now);
+    fprintf(stderr, "uart5               %llu tx, %llu rx, %llu cut by RS485_TX_EN\n",
+            stat.uart_tx, stat.uart_rx, stat.rs485_truncated);
+    fprintf(stderr, "page switches       %llu\n", stat.page_switch);
+    fprintf(stderr, "flash blocks        %llu\n", stat.flash_blocks);
+    fprintf(stderr, "os update / reset   %llu / %llu\n", stat.os_update, stat.sys_reset);
+    if(t5l_sim_fw_report) t5l_sim_fw_report();
+
+    if((s = getenv("T5L_SIM_DUMP")) != NULL)
+    {
+        unsigned long vp = strtoul(s, (char**)&s, 0);
+        unsigned long words = (*s == ',') ? strtoul(s + 1, NULL, 0) : 8;
+        for(i = 0; i < words; i++)
+        {
+            if((i & 7) == 0) fprintf(stderr, "%svp %04lX:", i ? "\n" : "", vp + i);
+            fprintf(stderr, " %04X", (t5l_sim_dgus(vp + i)[0] << 8) | t5l_sim_dgus(vp + i)[1]);
+        }
+        fprintf(stderr, "\n");
+    }
+}
+
+/**
+ * @brief Reset state and start the host tick before the firmware main() runs.
+ */
+static void __attribute__((constructor(200))) sim_init(void)
+{
+    const char* s;
+    unsigned long adc = 0x8080;
+    struct itimerval it;
+    unsigned n;
+
+    end_clk = SIM_CLK_PER_MS * (u64)((s = getenv("T5L_SIM_MS")) ? strtoul(s, NULL, 0) : 10000);
+
+    if((s = getenv("T5L_SIM_ADC")) != NULL) adc = strtoul(s, NULL, 0);
+    page_clk = SIM_CLK_PER_MS * (u64)((s = getenv("T5L_SIM_PAGE_MS")) ? strtoul(s, NULL, 0) : 15);
+    flash_block_clk = SIM_CLK_PER_MS * (u64)((s = getenv("T5L_SIM_FLASH_MS")) ? strtoul(s, NULL, 0) : 60);
+    for(n = 0; n < 8; n++)
+    {
+        dgus_ram[(0x0032 + n) * 2] = (u8)(adc >> 8);
+        dgus_ram[(0x0032 + n) * 2 + 1] = (u8)adc;
+    }
+
+    if((s = getenv("T5L_SIM_TOUCH")) != NULL)
+    {
+        long t0, t1, x, y;
+        if(sscanf(s, "%li,%li,%li,%li", &t0, &t1, &x, &y) == 4 && t1 > t0)
+        {
+            touch_at[0] = SIM_CLK_PER_MS * (u64)t0;
+            touch_at[1] = touch_at[0] + SIM_CLK_PER_MS;
+            touch_at[2] = SIM_CLK_PER_MS * (u64)t1;
+            touch_pos[0] = (u8)(x >> 8);
+            touch_pos[1] = (u8)x;
+            touch_pos[2] = (u8)(y >> 8);
+            touch_pos[3] = (u8)y;
+        }
+    }
+
+    if((s = getenv("T5L_SIM_RX")) != NULL) rx_load(s);
+    if((s = getenv("T5L_SIM_RX_FILE")) != NULL) rx_load_file(s);
+    if(rx_len)
+    {
+        rx_next = SIM_CLK_PER_MS * (u64)((s = getenv("T5L_SIM_RX_AT")) ? strtoul(s, NULL, 0) : 100);
+    }
+
+    // Port latches reset high, as on the ASIC
+    scatter(A_P0, 0xFF);
+    scatter(0x90, 0xFF);
+    scatter(0xA0, 0xFF);
+    scatter(0xB0, 0xFF);
+
+    // The benchmark runs on the bare register model, before any firmware init
+    if(getenv("T5L_SIM_BENCH") && t5l_sim_fw_bench)
+    {
+        t5l_sim_fw_bench();
+        exit(0);
+    }
+
+    signal(SIGALRM, sim_alarm);
+    it.it_interval.tv_sec = 2;
+    it.it_interval.tv_usec = 0;
+    it.it_value = it.it_interval;
+    setitimer(ITIMER_REAL, &it, NULL);
+
+    if(getenv("T5L_SIM_CHECK") && t5l_sim_fw_check)
+    {
+        in_check = 1;
+        exit(t5l_sim_fw_check() ? 1 : 0);
+    }
+}
@@ -0,0 +1,120 @@
+/**
+ * @file t5l_sim.h
+ * @brief Host-side T5L Register Layer Simulator.
+ * @details Force-included (gcc -include) into every firmware translation unit of
+ *          the host build. Maps the Keil C51 storage keywords to plain C and routes
+ *          every SFR / SBIT access of T5LOS8051.h through the simulator core, which
+ *          models DGUS RAM (ADR_H/M/L, ADR_INC, RAMMODE, DATA3..0, APP_EN),
+ *          Timer 0/1/2, UART5 and the interrupt controller.
+ *
+ *          The register map itself is not duplicated: the Makefile rewrites every
+ *          `sfr X = addr;` into `#define X T5L_SFR(addr)` and every
+ *          `sbit Y = X^n;` into `#define Y T5L_SBIT(T5L_ADDR_X, n)`.
+ *
+ *          Time is cycle-counted at the register interface: each SFR access, DGUS
+ *          handshake and ISR entry advances the virtual clock (FOSC = 206.4384 MHz),
+ *          timers and the UART run against that clock. Pure C computation between
+ *          register accesses costs no simulated time. A busy-wait that touches no
+ *          register (`while(!STimer_Expired(n));`) is rewritten by the Makefile to
+ *          call t5l_sim_idle(), which jumps the clock to the next hardware event,
+ *          so a run never depends on host timing.
+ *
+ *          NOTE: The host is little-endian, the C51 target is big-endian. u16/u32
+ *          values written straight from variables arrive in DGUS RAM byte-swapped;
+ *          byte buffers (as used for DGUS commands) are exact.
+ */
+
+#ifndef __T5L_SIM_H__
+#define __T5L_SIM_H__
+
+#ifndef T5L_SIM_CORE
+// --- Keil C51 Keywords ---
+#define data
+#define idata
+#define pdata
+#define xdata
+#define code
+#define bit         unsigned char
+#define reentrant
+#endif
+
+// --- Register Access ---
+#define T5L_SFR(addr)       (*t5l_sim_sfr(addr))
+#define T5L_SBIT(addr, n)   (*t5l_sim_bit((addr), (n)))
+
+/**
+ * @brief Bind a firmware ISR to its C51 interrupt number.
+ * @details Replaces the `interrupt n` suffix of the ISR definition. Registered
+ *          before sim_init() (constructor 200), so checks run from there get
+ *          their interrupts.
+ */
+#define T5L_SIM_VECTOR(isr, n)                                              \
+    void isr(void);                                                         \
+    static void __attribute__((constructor(101))) t5l_sim_vector_##isr(void) \
+    {                                                                       \
+        t5l_sim_set_vector((n), isr);                                       \
+    }
+
+/**
+ * @brief Access a byte SFR.
+ * @param addr SFR address (0x80-0xFF)
+ * @return Pointer valid until the next register access
+ */
+volatile unsigned char* t5l_sim_sfr(unsigned char addr);
+
+/**
+ * @brief Access one bit of a bit-addressable SFR.
+ * @param addr SFR address (multiple of 8)
+ * @param n Bit number (0-7)
+ * @return Pointer to the bit cell (0 or 1)
+ */
+volatile unsigned char* t5l_sim_bit(unsigned char addr, unsigned char n);
+
+/**
+ * @brief Idle hook of busy-waits
+ * @details If no register was accessed since the previous call, the clock
+ *          jumps to the next hardware event and the pending ISRs run; otherwise
+ *          the call only marks the access count. Also for host-side wait loops
+ *          (fw_check.c).
+ */
+void t5l_sim_idle(void);
+
+/**
+ * @brief Register an interrupt service routine.
+ * @param vector C51 interrupt number
+ * @param isr Service routine
+ */
+void t5l_sim_set_vector(unsigned char vector, void (*isr)(void));
+
+/**
+ * @brief Current simulated time in CPU clocks.
+ */
+unsigned long long t5l_sim_clock(void);
+
+/**
+ * @brief Direct view of the simulated DGUS RAM (big-endian, 2 bytes per VP word).
+ * @param vp VP word address
+ */
+unsigned char* t5l_sim_dgus(unsigned long vp);
+
+/**
+ * @brief Firmware-side report section (optional, see fw_report.c)
+ * @details Called at the end of the run report when linked in.
+ */
+void t5l_sim_fw_report(void) __attribute__((weak));
+
+/**
+ * @brief Firmware-side benchmark (optional, see fw_bench.c)
+ * @details Run instead of the firmware when T5L_SIM_BENCH is set.
+ */
+void t5l_sim_fw_bench(void) __attribute__((weak));
+
+/**
+ * @brief Firmware-side checks (optional, see fw_check.c)
+ * @details Run instead of the firmware when T5L_SIM_CHECK is set. Loops that
+ *          wait on Wait_Count call t5l_sim_idle() to advance.
+ * @return Number of failed checks
+ */
+int t5l_sim_fw_check(void) __attribute__((weak));
+
+#endif
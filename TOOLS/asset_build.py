@@ -0,0 +1,243 @@
+#!/usr/bin/env python3
+"""
+Incremental asset build for DGUS/DWIN_SET with a flash delta manifest.
+
+Rebuilds the icon libraries from their source folders with TOOLS/build/icl:
+
+    16.icl  DGUS/image            backgrounds
+    30.icl  DGUS/30, DGUS/ICON    icons (an ID exported to DGUS/30 wins)
+
+Every source image is hashed (SHA-256 of its bytes and the JPEG quality). The
+encoded JPEG is kept in TOOLS/build/asset_cache/<hash>.jpg. Only images without
+a cache entry are encoded, in one parallel icl run. The library is then packed
+from cached JPEGs, which icl stores without re-encoding. A library whose
+sources are unchanged is not touched at all.
+
+After the build, every numbered DWIN_SET file (00.bin, 13TouchFile.bin,
+14ShowFile.bin, 16.icl, 22_Config.bin, 30.icl) is compared in 32 KB flash
+blocks against a base (layout and diff in TOOLS/flash_blocks.py). The changed
+blocks go to a JSON manifest as the delta sessions TOOLS/flash_delta.py sends:
+
+    {"base": ..., "dwin_set": "DGUS/DWIN_SET", "block_bytes": 32768,
+     "sessions": [{"file": "16.icl", "block": 128, "idx": [0, 1, 2]}, ...],
+     "files": [{"file": "16.icl", "first_block": 128, "blocks": 3, "changed": [128, 129, 130],
+                "sha256": ..., ...}]}
+
+    python3 TOOLS/flash_delta.py send /dev/ttyUSB0 --manifest TOOLS/build/asset_delta.json
+
+The base is --base DIR (a copy of the DWIN_SET in the field) or, by default,
+the block hashes recorded by the previous build in TOOLS/build/asset_state.json.
+
+Without a state file (clean checkout) the state is seeded from the committed
+tree: the shipped 16.icl/30.icl count as built from the committed sources, and
+the committed DWIN_SET is the delta base. So a first run leaves the vendor
+libraries alone and only rebuilds a library whose sources differ from HEAD.
+Outside a git checkout the files on disk are taken as committed.
+
+    python3 TOOLS/asset_build.py                      build, write TOOLS/build/asset_delta.json
+    python3 TOOLS/asset_build.py --base release/DWIN_SET --manifest delta.json
+    python3 TOOLS/asset_build.py --check              only report what would be rebuilt
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import flash_blocks as fb
+
+ROOT = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+TOOLS = os.path.join(ROOT, "TOOLS")
+BUILD = os.path.join(TOOLS, "build")
+ICL = os.path.join(BUILD, "icl")
+CACHE = os.path.join(BUILD, "asset_cache")
+STATE = os.path.join(BUILD, "asset_state.json")
+MANIFEST = os.path.join(BUILD, "asset_delta.json")
+DWIN_SET = os.path.join(ROOT, "DGUS", "DWIN_SET")
+
+LIBS = [("16.icl", ["DGUS/image"]), ("30.icl", ["DGUS/30", "DGUS/ICON"])]
+IMAGE = re.compile(r"^(\d+).*\.(bmp|png|jpe?g)$", re.I)
+QUALITY = 90                    # icl default
+
+
+def sha(data):
+    return hashlib.sha256(data).hexdigest()
+
+
+def sources(folders):
+    """{id: path}, first folder first, first name in a folder first (as icl)."""
+    found = {}
+    for folder in folders:
+        path = os.path.join(ROOT, folder)
+        if not os.path.isdir(path):
+            continue
+        for name in sorted(os.listdir(path)):
+            m = IMAGE.match(name)
+            if m and int(m.group(1)) not in found:
+                found[int(m.group(1))] = os.path.join(path, name)
+    return found
+
+
+def committed(path):
+    """Bytes of a file in HEAD (on disk outside a git checkout), None if it is not there."""
+    rel = os.path.relpath(path, ROOT).replace(os.sep, "/")
+    r = subprocess.run(["git", "-C", ROOT, "show", "HEAD:" + rel], stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+    if r.returncode == 0:
+        return r.stdout
+    inside = subprocess.run(["git", "-C", ROOT, "rev-parse", "--verify", "-q", "HEAD"],
+                            stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL).returncode == 0
+    if inside or not os.path.exists(path):
+        return None
+    return open(path, "rb").read()
+
+
+def seed_state(quality):
+    """State of a clean checkout: shipped libraries and DWIN_SET as of HEAD."""
+    tag = ("q%d" % quality).encode()
+    state = {"libs": {}, "blocks": {}}
+    for name, folders in LIBS:
+        lib = committed(os.path.join(DWIN_SET, name))
+        if lib is None:
+            continue
+        keys = {}
+        for i, p in sorted(sources(folders).items()):
+            data = committed(p)
+            if data is not None:
+                keys[str(i)] = sha(data + tag)
+        state["libs"][name] = {"sources": keys, "sha256": sha(lib)}
+    for name in fb.dwin_files(DWIN_SET):
+        data = committed(os.path.join(DWIN_SET, name))
+        if data is not None:
+            state["blocks"][name] = fb.block_hashes(data)
+    return state
+
+
+def icl(*args):
+    r = subprocess.run([ICL] + list(args), stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+    if r.returncode:
+        sys.exit("icl %s failed:\n%s" % (" ".join(args), r.stderr))
+    return r.stdout
+
+
+def encode_missing(jobs, quality, threads):
+    """Encode the (id, path, key) jobs without a cache entry in one icl run."""
+    missing = [(i, p, k) for i, p, k in jobs if not os.path.exists(os.path.join(CACHE, k + ".jpg"))]
+    if not missing:
+        return 0
+    with tempfile.TemporaryDirectory() as tmp:
+        src, out = os.path.join(tmp, "src"), os.path.join(tmp, "out")
+        os.mkdir(src)
+        # icl wants numbered names; the index maps back to the cache key
+        for n, (_, path, _) in enumerate(missing):
+            os.symlink(path, os.path.join(src, "%d%s" % (n, os.path.splitext(path)[1])))
+        extra = ["-j", str(threads)] if threads else []
+        icl("pack", os.path.join(tmp, "tmp.icl"), src, "-q", str(quality), *extra)
+        icl("unpack", os.path.join(tmp, "tmp.icl"), out)
+        for n, (_, _, key) in enumerate(missing):
+            shutil.move(os.path.join(out, "%d.jpg" % n), os.path.join(CACHE, key + ".jpg"))
+    return len(missing)
+
+
+def build_lib(name, folders, state, args):
+    """Bring one library up to date; returns a status line."""
+    found = sources(folders)
+    if not found:
+        return "%s: no sources" % name
+    tag = ("q%d" % args.quality).encode()
+    jobs = [(i, p, sha(open(p, "rb").read() + tag)) for i, p in sorted(found.items())]
+    keys = {str(i): k for i, _, k in jobs}
+    out = os.path.join(DWIN_SET, name)
+    old = state.get("libs", {}).get(name, {})
+    current = os.path.exists(out) and sha(open(out, "rb").read()) == old.get("sha256")
+    if current and old.get("sources") == keys:
+        return "%s: up to date (%d images)" % (name, len(jobs))
+
+    changed = sorted(int(i) for i, k in keys.items() if old.get("sources", {}).get(i) != k)
+    if args.check:
+        return "%s: %d of %d images changed %s" % (name, len(changed), len(jobs), changed)
+
+    encoded = encode_missing(jobs, args.quality, args.jobs)
+    with tempfile.TemporaryDirectory() as tmp:
+        for i, _, k in jobs:
+            os.symlink(os.path.join(CACHE, k + ".jpg"), os.path.join(tmp, "%d.jpg" % i))
+        icl("pack", out, tmp)
+    state.setdefault("libs", {})[name] = {"sources": keys, "sha256": sha(open(out, "rb").read())}
+    return "%s: %d images, %d changed, %d encoded, %d from cache" % (
+        name, len(jobs), len(changed), encoded, len(jobs) - encoded)
+
+
+def block_hashes(path):
+    return fb.block_hashes(open(path, "rb").read())
+
+
+def delta(base_blocks, base_name):
+    """Manifest of the DWIN_SET blocks that differ from base_blocks {name: [hash]}."""
+    files, found = [], []
+    for name, fid in fb.dwin_files(DWIN_SET).items():
+        data = open(os.path.join(DWIN_SET, name), "rb").read()
+        new = fb.block_hashes(data)
+        first = fb.first_block(fid)
+        changed = [first + i for i in fb.changed(base_blocks.get(name, []), new)]
+        files.append({"file": name, "first_block": first, "blocks": len(new),
+                      "size": len(data), "sha256": sha(data), "changed": changed})
+        found += [{"file": name, "block": b, "idx": idx} for b, idx in fb.sessions(changed)]
+    return {"base": base_name, "dwin_set": os.path.relpath(DWIN_SET, ROOT), "block_bytes": fb.BLOCK_BYTES,
+            "sessions": found, "files": files}
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Incremental DWIN_SET asset build and flash delta manifest")
+    ap.add_argument("--base", metavar="DIR", help="DWIN_SET copy to diff against (default: previous build)")
+    ap.add_argument("--manifest", default=MANIFEST, help="delta manifest path")
+    ap.add_argument("--check", action="store_true", help="only report changed sources")
+    ap.add_argument("--quality", type=int, default=QUALITY, help="JPEG quality of re-encoded images")
+    ap.add_argument("-j", "--jobs", type=int, default=0, help="icl encoder threads (default: all CPUs)")
+    args = ap.parse_args()
+
+    if subprocess.run(["make", "-s", "-C", TOOLS, "build/icl"]).returncode:
+        sys.exit("cannot build TOOLS/build/icl")
+    os.makedirs(CACHE, exist_ok=True)
+    if os.path.exists(STATE):
+        state = json.load(open(STATE))
+        seeded = False
+    else:
+        state = seed_state(args.quality)
+        seeded = True
+        print("no %s: seeded from the committed DGUS/DWIN_SET" % os.path.relpath(STATE, ROOT))
+
+    for name, folders in LIBS:
+        print(build_lib(name, folders, state, args))
+    if args.check:
+        return
+
+    if args.base:
+        base = {n: block_hashes(os.path.join(args.base, n)) for n in fb.dwin_files(args.base)}
+        base_name = os.path.relpath(args.base, ROOT)
+    else:
+        base = state.get("blocks", {})
+        base_name = "committed DWIN_SET" if seeded else "previous build" if base else "empty flash"
+    manifest = delta(base, base_name)
+    with open(args.manifest, "w") as f:
+        json.dump(manifest, f, indent=1)
+        f.write("\n")
+
+    state["blocks"] = {n: block_hashes(os.path.join(DWIN_SET, n)) for n in fb.dwin_files(DWIN_SET)}
+    with open(STATE, "w") as f:
+        json.dump(state, f, indent=1)
+
+    total = sum(f["blocks"] for f in manifest["files"])
+    changed = sum(len(f["changed"]) for f in manifest["files"])
+    for f in manifest["files"]:
+        if f["changed"]:
+            print("%-16s blocks %s" % (f["file"], ",".join("%d" % b for b in f["changed"])))
+    print("delta vs %s: %d of %d flash blocks changed, %d delta sessions -> %s"
+          % (base_name, changed, total, len(manifest["sessions"]), os.path.relpath(args.manifest, ROOT)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,380 @@
+/**
+ * @file dgus_bg.c
+ * @brief DGUS Background Converter (RGB888 to RGB565).
+ * @details Converts a folder of numbered backgrounds (BMP/PNG/JPEG, e.g. DGUS/image)
+ *          into one raw RGB565 image for the panel's NOR flash:
+ *
+ *              dgus_bg OUT.bin DIR [-s WxH] [-d none|bayer] [-j jobs] [-b rounds]
+ *
+ *          Pixels are big-endian words, as in DGUS RAM. Every picture starts on a
+ *          32 KB flash block (800x480 = 24 blocks), so the file can be written
+ *          with the flash engine or TOOLS/uart_update.py --target flash; the block
+ *          of each picture is printed. -s checks the screen size (SCREENDSIZE of
+ *          DWprj.hmi), -d bayer adds 4x4 ordered dithering against banding.
+ *
+ *          The conversion handles 16 pixels per step with SSSE3 (byte shuffles to
+ *          split R, G, B, dithering as a saturating add on the packed bytes), with
+ *          a scalar fallback. Images are converted on -j threads (default: one per
+ *          CPU). -b N loads the images once and reports megapixels per second of
+ *          N conversion rounds for each code path instead of writing OUT.
+ *
+ *          Backgrounds stored as JPEG (16.icl) are built with TOOLS/icl.
+ */
+
+#include "img.h"
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
+typedef unsigned char  u8;
+typedef unsigned short u16;
+
+#define BG_BLOCK_BYTES      32768UL     // NOR flash block (flash.h FLASH_BLOCK_BYTES)
+#define BG_MAX_ID           0xFFFF
+
+typedef struct
+{
+    int     id;
+    char    path[PATH_MAX];
+    img_rgb img;
+    u8*     out;                        // w * h * 2 bytes, big-endian RGB565
+    char    err[PATH_MAX + 64];
+} bg_job;
+
+typedef void (*bg_convert)(const u8* rgb, u8* out, int w, int h, int dither);
+
+static bg_job* jobs;
+static int job_count;
+static int job_next;
+static int dither;
+static int load_only;
+static bg_convert convert;
+
+// 4x4 Bayer matrix, 0..15
+static const u8 bayer[4][4] =
+{
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 },
+};
+
+/** Threshold added to the R, G or B byte: below one output step (8 for R/B, 4 for G) */
+static u8 threshold(int x, int y, int c)
+{
+    return c == 1 ? bayer[y & 3][x & 3] >> 2 : bayer[y & 3][x & 3] >> 1;
+}
+
+static u8 sat_add(u8 a, u8 b)
+{
+    return a + b > 255 ? 255 : a + b;
+}
+
+// --- Conversion ---
+
+static void convert_scalar(const u8* rgb, u8* out, int w, int h, int dith)
+{
+    int x, y;
+    for (y = 0; y < h; y++)
+        for (x = 0; x < w; x++, rgb += 3, out += 2)
+        {
+            u8 r = rgb[0], g = rgb[1], b = rgb[2];
+            if (dith)
+            {
+                r = sat_add(r, threshold(x, y, 0));
+                g = sat_add(g, threshold(x, y, 1));
+                b = sat_add(b, threshold(x, y, 2));
+            }
+            out[0] = (r & 0xF8) | (g >> 5);
+            out[1] = ((g << 3) & 0xE0) | (b >> 3);
+        }
+}
+
+#ifdef __SSSE3__
+/**
+ * @brief 16 pixels per step: three 16-byte loads, pshufb into R, G and B planes,
+ *        RGB565 high/low bytes built with 16-bit shifts and byte masks
+ */
+static void convert_ssse3(const u8* rgb, u8* out, int w, int h, int dith)
+{
+    // Source byte of R/G/B for pixels 0..15 within each 16-byte load (-1 = other load)
+    const __m128i r0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i r1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+    const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+    const __m128i g0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+    const __m128i g2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+    const __m128i b0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+    const __m128i m_f8 = _mm_set1_epi8((char)0xF8);
+    const __m128i m_07 = _mm_set1_epi8(0x07);
+    const __m128i m_e0 = _mm_set1_epi8((char)0xE0);
+    const __m128i m_1f = _mm_set1_epi8(0x1F);
+    __m128i t[4][3];
+    int x, y, n, c;
+
+    // Per row phase: thresholds of 16 pixels (four Bayer periods) as packed RGB bytes
+    for (y = 0; y < 4; y++)
+        for (n = 0; n < 3; n++)
+        {
+            u8 v[16];
+            for (c = 0; c < 16; c++)
+                v[c] = dith ? threshold((n * 16 + c) / 3, y, (n * 16 + c) % 3) : 0;
+            t[y][n] = _mm_loadu_si128((const __m128i*)v);
+        }
+
+    for (y = 0; y < h; y++)
+    {
+        const u8* src = rgb + (size_t)y * w * 3;
+        u8* dst = out + (size_t)y * w * 2;
+        for (x = 0; x + 16 <= w; x += 16, src += 48, dst += 32)
+        {
+            __m128i a0 = _mm_loadu_si128((const __m128i*)src);
+            __m128i a1 = _mm_loadu_si128((const __m128i*)(src + 16));
+            __m128i a2 = _mm_loadu_si128((const __m128i*)(src + 32));
+            __m128i r, g, b, hi, lo;
+            if (dith)
+            {
+                a0 = _mm_adds_epu8(a0, t[y & 3][0]);
+                a1 = _mm_adds_epu8(a1, t[y & 3][1]);
+                a2 = _mm_adds_epu8(a2, t[y & 3][2]);
+            }
+            r = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, r0), _mm_shuffle_epi8(a1, r1)), _mm_shuffle_epi8(a2, r2));
+            g = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, g0), _mm_shuffle_epi8(a1, g1)), _mm_shuffle_epi8(a2, g2));
+            b = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, b0), _mm_shuffle_epi8(a1, b1)), _mm_shuffle_epi8(a2, b2));
+            // hi = RRRRRGGG, lo = GGGBBBBB (16-bit shifts, masks drop the bits of the neighbour byte)
+            hi = _mm_or_si128(_mm_and_si128(r, m_f8), _mm_and_si128(_mm_srli_epi16(g, 5), m_07));
+            lo = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(g, 3), m_e0), _mm_and_si128(_mm_srli_epi16(b, 3), m_1f));
+            _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi8(hi, lo));
+            _mm_storeu_si128((__m128i*)(dst + 16), _mm_unpackhi_epi8(hi, lo));
+        }
+        // Row tail: the same formula per pixel (x keeps the Bayer phase)
+        for (; x < w; x++, src += 3, dst += 2)
+        {
+            u8 r = src[0], g = src[1], b = src[2];
+            if (dith)
+            {
+                r = sat_add(r, threshold(x, y, 0));
+                g = sat_add(g, threshold(x, y, 1));
+                b = sat_add(b, threshold(x, y, 2));
+            }
+            dst[0] = (r & 0xF8) | (g >> 5);
+            dst[1] = ((g << 3) & 0xE0) | (b >> 3);
+        }
+    }
+}
+#endif
+
+// --- Jobs ---
+
+static double now_ms(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1e6;
+}
+
+static void die(const char* fmt, const char* arg)
+{
+    fprintf(stderr, "dgus_bg: ");
+    fprintf(stderr, fmt, arg);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+static void* worker(void* arg)
+{
+    int i;
+    (void)arg;
+    while ((i = __sync_fetch_and_add(&job_next, 1)) < job_count)
+    {
+        bg_job* j = &jobs[i];
+        if (!j->img.rgb && img_load(j->path, &j->img, j->err, sizeof(j->err)))
+            continue;
+        if (load_only)
+            continue;
+        if (!j->out)
+            j->out = malloc((size_t)j->img.w * j->img.h * 2);
+        convert(j->img.rgb, j->out, j->img.w, j->img.h, dither);
+    }
+    return NULL;
+}
+
+/** Run the job list on `threads` threads, return the wall time in ms */
+static double run(int threads)
+{
+    pthread_t tid[256];
+    double t0 = now_ms();
+    int i;
+
+    job_next = 0;
+    if (threads > job_count)
+        threads = job_count;
+    for (i = 0; i < threads; i++)
+        pthread_create(&tid[i], NULL, worker, NULL);
+    for (i = 0; i < threads; i++)
+        pthread_join(tid[i], NULL);
+    return now_ms() - t0;
+}
+
+static int job_cmp(const void* a, const void* b)
+{
+    const bg_job* x = a;
+    const bg_job* y = b;
+    return x->id != y->id ? x->id - y->id : strcmp(x->path, y->path);
+}
+
+static void scan_dir(const char* dir)
+{
+    DIR* d = opendir(dir);
+    struct dirent* de;
+    int cap = 0;
+
+    if (!d)
+        die("cannot open %s", dir);
+    while ((de = readdir(d)))
+    {
+        const char* dot = strrchr(de->d_name, '.');
+        char* end;
+        long id = strtol(de->d_name, &end, 10);
+        if (de->d_name[0] < '0' || de->d_name[0] > '9' || id > BG_MAX_ID || !dot ||
+            (strcasecmp(dot, ".bmp") && strcasecmp(dot, ".png") && strcasecmp(dot, ".jpg") && strcasecmp(dot, ".jpeg")))
+            continue;
+        if (job_count == cap)
+            jobs = realloc(jobs, (cap = cap ? cap * 2 : 16) * sizeof(*jobs));
+        memset(&jobs[job_count], 0, sizeof(*jobs));
+        jobs[job_count].id = (int)id;
+        snprintf(jobs[job_count].path, PATH_MAX, "%s/%s", dir, de->d_name);
+        job_count++;
+    }
+    closedir(d);
+    if (!job_count)
+        die("no numbered images in %s", dir);
+    qsort(jobs, job_count, sizeof(*jobs), job_cmp);
+}
+
+static void bench(int threads, int rounds)
+{
+    static const struct { const char* name; bg_convert fn; } paths[] =
+    {
+        { "scalar", convert_scalar },
+#ifdef __SSSE3__
+        { "ssse3", convert_ssse3 },
+#endif
+    };
+    double mpix = 0;
+    int p, d, t, r, i;
+
+    for (i = 0; i < job_count; i++)
+        mpix += jobs[i].img.w * (double)jobs[i].img.h / 1e6;
+    printf("%d images, %.2f MP per round, %d rounds\n", job_count, mpix, rounds);
+    for (p = 0; p < (int)(sizeof(paths) / sizeof(paths[0])); p++)
+        for (d = 0; d < 2; d++)
+            for (t = 1;; t = threads)
+            {
+                double ms = 0;
+                convert = paths[p].fn;
+                dither = d;
+                run(t);                 // Warm-up: allocates the outputs
+                for (r = 0; r < rounds; r++)
+                    ms += run(t);
+                printf("%-7s %-6s %2d thread(s) %8.1f MP/s\n", paths[p].name, d ? "bayer" : "none", t,
+                       mpix * rounds / (ms / 1000.0));
+                if (t == threads)
+                    break;
+            }
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: dgus_bg OUT.bin DIR [-s WxH] [-d none|bayer] [-j jobs] [-b rounds]\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int sw = 0, sh = 0, rounds = 0, errors = 0, opt, i;
+    unsigned long pos = 0;
+    double ms;
+    FILE* f;
+
+#ifdef __SSSE3__
+    convert = convert_ssse3;
+#else
+    convert = convert_scalar;
+#endif
+    while ((opt = getopt(argc, argv, "s:d:j:b:")) != -1)
+    {
+        if (opt == 's' && sscanf(optarg, "%dx%d", &sw, &sh) == 2)
+            continue;
+        if (opt == 'd' && (!strcmp(optarg, "none") || !strcmp(optarg, "bayer")))
+            dither = !strcmp(optarg, "bayer");
+        else if (opt == 'j')
+            threads = atoi(optarg);
+        else if (opt == 'b')
+            rounds = atoi(optarg);
+        else
+            usage();
+    }
+    if (argc - optind != 2 || threads < 1 || threads > 256)
+        usage();
+    scan_dir(argv[optind + 1]);
+
+    load_only = 1;
+    run(threads);
+    load_only = 0;
+    for (i = 0; i < job_count; i++)
+    {
+        bg_job* j = &jobs[i];
+        if (!j->err[0] && i && jobs[i - 1].id == j->id)
+            snprintf(j->err, sizeof(j->err), "%s: picture %d is given twice", j->path, j->id);
+        if (!j->err[0] && sw && (j->img.w != sw || j->img.h != sh))
+            snprintf(j->err, sizeof(j->err), "%s: %dx%d, screen is %dx%d", j->path, j->img.w, j->img.h, sw, sh);
+        if (j->err[0])
+        {
+            fprintf(stderr, "dgus_bg: %s\n", j->err);
+            errors++;
+        }
+    }
+    if (errors)
+        return 1;
+
+    if (rounds > 0)
+    {
+        bench(threads, rounds);
+        return 0;
+    }
+
+    ms = run(threads);
+    f = fopen(argv[optind], "wb");
+    if (!f)
+        die("cannot write %s", argv[optind]);
+    for (i = 0; i < job_count; i++)
+    {
+        bg_job* j = &jobs[i];
+        unsigned long len = (unsigned long)j->img.w * j->img.h * 2;
+        unsigned long pad = (BG_BLOCK_BYTES - len % BG_BLOCK_BYTES) % BG_BLOCK_BYTES;
+        static const u8 zero[BG_BLOCK_BYTES];
+        printf("%5d  %4dx%-4d block %3lu..%-3lu %s\n", j->id, j->img.w, j->img.h, pos / BG_BLOCK_BYTES,
+               (pos + len + pad) / BG_BLOCK_BYTES - 1, j->path);
+        if (fwrite(j->out, 1, len, f) != len || fwrite(zero, 1, pad, f) != pad)
+            die("cannot write %s", argv[optind]);
+        pos += len + pad;
+    }
+    if (fclose(f))
+        die("cannot write %s", argv[optind]);
+    printf("%s: %d images, %lu bytes, converted in %.1f ms (%s%s)\n", argv[optind], job_count, pos, ms,
+           convert == convert_scalar ? "scalar" : "ssse3", dither ? ", bayer dither" : "");
+    return 0;
+}
@@ -0,0 +1,266 @@
+#!/usr/bin/env python3
+"""
+VP usage map of a DGUS II project (14ShowFile.bin + 13TouchFile.bin).
+
+Decodes every display control descriptor (page, type, VP, position) and every
+touch control (page, rectangle, type, VP, page switch), lists which VPs the
+project reads and writes, reports overlapping VP ranges and the free blocks in
+the user VP space, and can emit the map as a C header or JSON:
+
+    python3 TOOLS/dgus_map.py                      table + overlaps + free blocks
+    python3 TOOLS/dgus_map.py --json               same data as JSON
+    python3 TOOLS/dgus_map.py --header map.h       C header (DGUS_VP_xxxx defines)
+    python3 TOOLS/dgus_map.py --dir other/DWIN_SET
+
+Exits with status 1 if two controls use partly overlapping VP ranges or one
+VP with different sizes, so it can guard a build script. Also imported by
+TOOLS/vp_bind.py.
+
+VP sizes: data variables (variable type) and text (Text_Length) are decoded,
+icons and sliders use one word. For the other controls the descriptor does not
+give the size (curves read the curve buffers, basic graphics and hex data take a
+command or byte count from VP RAM): they are marked "size unknown" ("?" in the
+table, "sized": false in JSON) and counted as one word in the overlap and
+free-block checks.
+
+File layout (as written by the DGUS tool):
+
+  14ShowFile.bin  "\\x14DGUS_2" header; page index from 0x10 to 0x4000, 4 bytes
+                  per page (descriptor count, 0, byte offset); 32-byte
+                  descriptors 5A TYPE SP(2) LEN(2) VP(2) X(2) Y(2) ..., the
+                  control's SP words from VP on (SP word n at byte 4 + 2n)
+  13TouchFile.bin 32-byte entries PAGE X0 Y0 X1 Y1 NEXT ON FD CODE, then FE VP(2)
+                  for controls that write a VP; FFFF ends the file
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+DWIN_SET = os.path.join(ROOT, "DGUS", "DWIN_SET")
+
+SHOW_INDEX, SHOW_INDEX_END, SHOW_DESC = 0x10, 0x4000, 32
+TOUCH_DESC = 32
+NO_PAGE = 0xFF00                # NEXT / ON field: no page switch
+USER_VP = (0x1000, 0xFFFF)      # user VP space (free-block report)
+
+SHOW_TYPES = {
+    0x00: "variable icon", 0x01: "animation icon", 0x02: "slider", 0x03: "artistic variable",
+    0x04: "image animation", 0x05: "icon rotation", 0x06: "bit icon", 0x10: "data variable",
+    0x11: "text", 0x12: "rtc", 0x13: "hex data", 0x14: "text scroll", 0x20: "curve",
+    0x21: "basic graphics",
+}
+TOUCH_TYPES = {
+    0x00: "data input", 0x01: "popup menu", 0x02: "increment", 0x03: "drag adjust",
+    0x05: "return key", 0x06: "text input", 0x08: "sync return", 0x0A: "rotation adjust",
+    0x0B: "slide screen", 0x0D: "bit button",
+}
+# Data variable: words and C name by variable type (descriptor byte 0x13)
+DATA_TYPES = {0: (1, "int"), 1: (2, "long"), 2: (1, "VP high byte"), 3: (1, "VP low byte"),
+              4: (4, "long long"), 5: (1, "unsigned int"), 6: (2, "unsigned long")}
+NO_VP_TYPES = (0x12,)           # RTC reads the system clock
+ONE_WORD_TYPES = (0x00, 0x01, 0x02, 0x04, 0x05, 0x06)
+TEXT_LENGTH = 0x16              # text: SP word 0x09, length in bytes
+
+
+def _u16(d, i):
+    return (d[i] << 8) | d[i + 1]
+
+
+def _show_entry(page, d):
+    kind = d[1]
+    c = {"source": "display", "page": page, "type": SHOW_TYPES.get(kind, "type 0x%02X" % kind),
+         "sp": _u16(d, 2), "vp": _u16(d, 6), "words": 1, "sized": True, "rect": None}
+    x, y = _u16(d, 8), _u16(d, 10)
+    if kind == 0x10:
+        words, name = DATA_TYPES.get(d[0x13], (1, "type %d" % d[0x13]))
+        digits = d[0x11] + d[0x12] + (1 if d[0x12] else 0)
+        # Font cell is size/2 wide for digits; the anchor depends on alignment
+        w, h = digits * d[0x0F] // 2, d[0x0F]
+        x0 = {1: x - w, 2: x - w // 2}.get(d[0x10], x)
+        c.update(words=words, type="data variable (%s)" % name, rect=(x0, y, x0 + w - 1, y + h - 1))
+    else:
+        c["rect"] = (x, y, x, y)
+    if kind == 0x11:
+        c["words"] = max(1, (_u16(d, TEXT_LENGTH) + 1) // 2)
+    elif kind not in ONE_WORD_TYPES + NO_VP_TYPES + (0x10,):
+        c["sized"] = False
+    if kind in NO_VP_TYPES:
+        c["vp"] = None
+    return c
+
+
+def read_show(path):
+    """Display controls of 14ShowFile.bin, in page order."""
+    data = open(path, "rb").read()
+    if data[1:7] != b"DGUS_2":
+        raise ValueError("%s: not a DGUS II show file" % path)
+    out = []
+    index = struct.unpack_from(">%dI" % ((SHOW_INDEX_END - SHOW_INDEX) // 4), data, SHOW_INDEX)
+    for page, entry in enumerate(index):
+        count, ofs = entry >> 24, entry & 0xFFFF
+        for n in range(count):
+            d = data[ofs + n * SHOW_DESC:ofs + (n + 1) * SHOW_DESC]
+            if len(d) == SHOW_DESC and d[0] == 0x5A:
+                out.append(_show_entry(page, d))
+    return out
+
+
+def read_touch(path):
+    """Touch controls of 13TouchFile.bin."""
+    data = open(path, "rb").read()
+    out = []
+    for pos in range(0, len(data) - TOUCH_DESC + 1, TOUCH_DESC):
+        d = data[pos:pos + TOUCH_DESC]
+        page, x0, y0, x1, y1, nxt = struct.unpack_from(">6H", d)
+        if page == 0xFFFF:
+            break
+        kind = d[0x0F]
+        c = {"source": "touch", "page": page, "type": TOUCH_TYPES.get(kind, "type 0x%02X" % kind),
+             "vp": _u16(d, 0x11) if d[0x10] == 0xFE else None, "words": 1, "sized": True,
+             "rect": (x0, y0, x1, y1), "next": None if nxt == NO_PAGE else nxt}
+        out.append(c)
+    return out
+
+
+def read_project(folder=DWIN_SET):
+    """All controls of a DWIN_SET folder (display first, then touch)."""
+    return (read_show(os.path.join(folder, "14ShowFile.bin")) +
+            read_touch(os.path.join(folder, "13TouchFile.bin")))
+
+
+def vp_ranges(controls):
+    """{vp: [controls]} for every control that uses a VP."""
+    ranges = {}
+    for c in controls:
+        if c["vp"] is not None:
+            ranges.setdefault(c["vp"], []).append(c)
+    return ranges
+
+
+def overlaps(controls):
+    """Conflicts: partly overlapping VP ranges, or one VP used with different (known) sizes."""
+    found = []
+    items = sorted((c for c in controls if c["vp"] is not None), key=lambda c: (c["vp"], -c["words"]))
+    for i, a in enumerate(items):
+        end = a["vp"] + a["words"]
+        for b in items[i + 1:]:
+            if b["vp"] >= end:
+                break
+            if b["vp"] != a["vp"] or (b["words"] != a["words"] and a["sized"] and b["sized"]):
+                found.append((a, b))
+    return found
+
+
+def free_blocks(controls, lo=USER_VP[0], hi=USER_VP[1]):
+    """Unused VP blocks of the user space as (first, words), largest first."""
+    used = sorted((c["vp"], c["vp"] + c["words"]) for c in controls if c["vp"] is not None)
+    blocks = []
+    pos = lo
+    for start, end in used:
+        if end <= pos:
+            continue
+        if start > pos:
+            blocks.append((pos, min(start, hi + 1) - pos))
+        pos = max(pos, end)
+    if pos <= hi:
+        blocks.append((pos, hi + 1 - pos))
+    return sorted((b for b in blocks if b[1] > 0), key=lambda b: -b[1])
+
+
+def describe(c):
+    text = "page %d %s %s" % (c["page"], c["source"], c["type"])
+    if not c["sized"]:
+        text += " (size unknown)"
+    r = c["rect"]
+    if r and r[:2] == r[2:]:
+        text += " @(%d,%d)" % r[:2]
+    elif r:
+        text += " (%d,%d)-(%d,%d)" % r
+    if c.get("next") is not None:
+        text += " -> page %d" % c["next"]
+    return text
+
+
+def size_text(users):
+    """Words of a VP as the table shows them, "?" if a control's size is unknown."""
+    return "%d%s" % (max(c["words"] for c in users), "" if all(c["sized"] for c in users) else "?")
+
+
+def print_map(controls):
+    ranges = vp_ranges(controls)
+    for vp in sorted(ranges):
+        users = ranges[vp]
+        rw = "".join(sorted({"r" if c["source"] == "display" else "w" for c in users}))
+        for n, c in enumerate(users):
+            head = "0x%04X %-2s %-2s " % (vp, size_text(users), rw) if n == 0 else " " * 13
+            print(head + describe(c))
+    for c in controls:
+        if c["vp"] is None:
+            print("  -          " + describe(c))
+
+
+def write_header(controls, path, source):
+    ranges = vp_ranges(controls)
+    lines = [
+        "/**",
+        " * @file %s" % os.path.basename(path),
+        " * @brief VP usage of the DGUS project, generated by TOOLS/dgus_map.py.",
+        " * @details Do not edit. Source: %s. r = shown by a display control," % source,
+        " *          w = written by a touch control. Free blocks are listed largest first.",
+        " */",
+        "",
+        "#ifndef __%s__" % os.path.basename(path).upper().replace(".", "_"),
+        "#define __%s__" % os.path.basename(path).upper().replace(".", "_"),
+        "",
+    ]
+    for vp in sorted(ranges):
+        users = ranges[vp]
+        rw = "".join(sorted({"r" if c["source"] == "display" else "w" for c in users}))
+        lines.append("#define DGUS_VP_%04X            0x%04X  // %s word(s) %s: %s"
+                     % (vp, vp, size_text(users), rw,
+                        "; ".join(describe(c) for c in users)))
+    lines += ["", "#define DGUS_VP_COUNT           %d" % len(ranges), ""]
+    for i, (vp, words) in enumerate(free_blocks(controls)[:8]):
+        lines.append("#define %-23s 0x%04X  // %d words" % ("DGUS_FREE%d_VP" % i, vp, words))
+    lines += ["", "#endif", ""]
+    with open(path, "w", newline="\n") as f:
+        f.write("\n".join(lines))
+
+
+def main():
+    ap = argparse.ArgumentParser(description="VP usage map of a DGUS II project")
+    ap.add_argument("--dir", default=DWIN_SET, help="DWIN_SET folder")
+    ap.add_argument("--json", action="store_true", help="print JSON instead of the table")
+    ap.add_argument("--header", metavar="FILE", help="also write a C header")
+    args = ap.parse_args()
+
+    controls = read_project(args.dir)
+    conflicts = overlaps(controls)
+
+    if args.json:
+        json.dump({"controls": controls,
+                   "overlaps": [[a["vp"], b["vp"]] for a, b in conflicts],
+                   "free": free_blocks(controls)}, sys.stdout, indent=1)
+        print()
+    else:
+        print_map(controls)
+        for a, b in conflicts:
+            print("overlap: 0x%04X/%d (%s) and 0x%04X/%d (%s)"
+                  % (a["vp"], a["words"], describe(a), b["vp"], b["words"], describe(b)))
+        free = free_blocks(controls)
+        unknown = sum(1 for c in controls if c["vp"] is not None and not c["sized"])
+        print("%d controls, %d VPs, %d overlaps, largest free block 0x%04X (%d words)%s"
+              % (len(controls), len(vp_ranges(controls)), len(conflicts), free[0][0], free[0][1],
+                 ", %d size(s) unknown" % unknown if unknown else ""))
+
+    if args.header:
+        write_header(controls, args.header, os.path.relpath(args.dir, ROOT))
+    sys.exit(1 if conflicts else 0)
+
+
+if __name__ == "__main__":
+    main()
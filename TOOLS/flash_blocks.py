@@ -0,0 +1,66 @@
+"""
+DWIN_SET flash block layout and block diff, shared by TOOLS/asset_build.py
+and TOOLS/flash_delta.py.
+
+File N of a DWIN_SET folder starts at flash block N * 8 (256 KB per file ID,
+as in Test_Flash_Write_Full_16ICL); a block is 32 KB, the unit of the VP
+0x00AA flash command. The last block of a file is padded with erased flash
+(0xFF) before it is hashed or sent, so both tools see the same blocks.
+
+Changed blocks are grouped into delta sessions of KEIL/update.c
+(UPDATE_TARGET_DELTA): one session per file run of at most DELTA_MAX blocks,
+each block named by a one-byte IDX relative to the session's first block.
+"""
+
+import hashlib
+import os
+import re
+
+BLOCK_BYTES = 32768             # flash.h FLASH_BLOCK_BYTES
+BLOCKS_PER_ID = 8               # 256 KB per DWIN_SET file ID
+DELTA_MAX = 64                  # update.h UPDATE_DELTA_MAX
+FILE_ID = re.compile(r"^(\d+).*\.(bin|icl)$", re.I)
+
+
+def file_id(name):
+    """DWIN_SET file ID of a file name, None if it is not a numbered .bin/.icl."""
+    m = FILE_ID.match(os.path.basename(name))
+    return int(m.group(1)) if m else None
+
+
+def first_block(fid):
+    return fid * BLOCKS_PER_ID
+
+
+def dwin_files(folder):
+    """{name: file ID} of the flash files in a DWIN_SET folder."""
+    if not folder or not os.path.isdir(folder):
+        return {}
+    return {n: file_id(n) for n in sorted(os.listdir(folder)) if file_id(n) is not None}
+
+
+def blocks(data):
+    """32 KB blocks of a file, the last one padded with erased flash."""
+    data += b"\xff" * (-len(data) % BLOCK_BYTES)
+    return [data[i:i + BLOCK_BYTES] for i in range(0, len(data), BLOCK_BYTES)]
+
+
+def block_hashes(data):
+    """SHA-256 of every block of a file (as blocks() pads it)."""
+    return [hashlib.sha256(b).hexdigest() for b in blocks(data)]
+
+
+def changed(old, new):
+    """Indices of the blocks of `new` that differ from `old` (both hash lists)."""
+    return [i for i in range(len(new)) if i >= len(old) or old[i] != new[i]]
+
+
+def sessions(numbers):
+    """Group ascending absolute block numbers into delta sessions [(first block, [IDX])]."""
+    out = []
+    for n in numbers:
+        # IDX is one byte relative to the session's block
+        if not out or len(out[-1][1]) == DELTA_MAX or n - out[-1][0] > 0xFF:
+            out.append((n, []))
+        out[-1][1].append(n - out[-1][0])
+    return out
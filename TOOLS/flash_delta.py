@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""
+Delta flash update of DWIN_SET files by 32 KB block diff.
+
+Compares the copy in the field (OLD) with the new build (NEW) in 32 KB flash
+blocks, the unit of the VP 0x00AA flash command, and sends only the blocks that
+differ. OLD and NEW are two files or two DWIN_SET folders; for folders every
+numbered .bin/.icl file is compared. Instead of OLD and NEW, --manifest takes
+the delta sessions TOOLS/asset_build.py wrote (its asset_delta.json) and sends
+them from the manifest's DWIN_SET; a file changed since the manifest was
+written is refused. Block layout, diff and session grouping are the ones of
+TOOLS/flash_blocks.py in both cases.
+
+The blocks go through the update protocol of KEIL/update.c with the delta
+target: BEGIN carries one IDX CRC16 entry per changed block, DATA streams the
+changed blocks back to back, and the firmware checks and writes each block as
+soon as it is complete, double buffered in the two flash staging buffers. A
+CRC mismatch or flash timeout stops the session; blocks written before it
+already hold their new contents, so running the tool again only sends the rest.
+
+    python3 TOOLS/flash_delta.py diff old/16.icl DGUS/DWIN_SET/16.icl
+    python3 TOOLS/flash_delta.py send /dev/ttyUSB0 release/DWIN_SET DGUS/DWIN_SET
+    python3 TOOLS/flash_delta.py send /dev/ttyUSB0 --manifest TOOLS/build/asset_delta.json
+    python3 TOOLS/flash_delta.py sim old/16.icl new/16.icl frames.bin
+        (raw frames for T5L_SIM_RX_FILE of SIM/build/t5l_sim)
+
+Needs pyserial for a real port.
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import sys
+import time
+
+import flash_blocks as fb
+import uart_update as uu
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+
+def file_id(path, given):
+    if given is not None:
+        return given
+    fid = fb.file_id(path)
+    if fid is None:
+        sys.exit("%s: no file ID in the name, give --id" % path)
+    return fid
+
+
+def pairs(old, new, given):
+    """[(name, file ID, old bytes, new bytes)] to compare."""
+    if os.path.isdir(new):
+        return [(n, fid,
+                 open(os.path.join(old, n), "rb").read() if os.path.exists(os.path.join(old, n)) else b"",
+                 open(os.path.join(new, n), "rb").read()) for n, fid in fb.dwin_files(new).items()]
+    return [(os.path.basename(new), file_id(new, given), open(old, "rb").read(), open(new, "rb").read())]
+
+
+def with_data(found, first, data):
+    """Delta sessions [(block, [IDX])] of one file as (first block, [(IDX, block data)])."""
+    b = fb.blocks(data)
+    return [(base, [(i, b[base + i - first]) for i in idx]) for base, idx in found]
+
+
+def diff_plan(args):
+    """[(name, first block, blocks, sessions)] from OLD and NEW."""
+    out = []
+    for name, fid, old, new in pairs(args.old, args.new, args.id):
+        first = fb.first_block(fid)
+        changed = [first + i for i in fb.changed(fb.block_hashes(old), fb.block_hashes(new))]
+        out.append((name, first, len(fb.blocks(new)), with_data(fb.sessions(changed), first, new)))
+    return out
+
+
+def manifest_plan(args):
+    """[(name, first block, blocks, sessions)] from an asset_build.py manifest."""
+    m = json.load(open(args.manifest))
+    folder = os.path.join(ROOT, m["dwin_set"])
+    out = []
+    for f in m["files"]:
+        data = open(os.path.join(folder, f["file"]), "rb").read()
+        if hashlib.sha256(data).hexdigest() != f["sha256"]:
+            sys.exit("%s changed since %s was written, run asset_build.py again" % (f["file"], args.manifest))
+        found = [(s["block"], s["idx"]) for s in m["sessions"] if s["file"] == f["file"]]
+        out.append((f["file"], f["first_block"], f["blocks"], with_data(found, f["first_block"], data)))
+    return out
+
+
+def begin(base, items):
+    image = b"".join(d for _, d in items)
+    table = b"".join(bytes([i]) + uu.crc16(d).to_bytes(2, "big") for i, d in items)
+    return image, uu.begin_frame(image, "delta", base, table)
+
+
+def plan(args):
+    todo, total = [], 0
+    for name, first, n, found in (manifest_plan(args) if args.manifest else diff_plan(args)):
+        changed = sum(len(s[1]) for s in found)
+        total += n
+        print("%-16s blocks %3d-%-3d  %2d of %2d changed  %s" % (
+            name, first, first + n - 1, changed, n,
+            ",".join("%d" % (base + i) for base, items in found for i, _ in items)))
+        todo += found
+    sent = sum(len(s[1]) for s in todo)
+    secs = lambda n: n * uu.BLOCK_BYTES * 10.0 / args.baud
+    print("%d of %d blocks to write, %.0f s instead of %.0f s at %d baud" % (
+        sent, total, secs(sent), secs(total), args.baud))
+    return todo
+
+
+def run_serial(args, todo):
+    link = uu.Link(args.port, args.baud)
+    for base, items in todo:
+        image, frame = begin(base, items)
+        t0 = time.time()
+        ok, state, error, nxt = uu.transact(link, frame, uu.CMD_BEGIN)
+        if ok and nxt and len(image) > 0x20000:
+            # A 16-bit NEXT is ambiguous beyond 128 KB: start over
+            uu.transact(link, uu.frame(uu.CMD_ABORT), uu.CMD_ABORT)
+            ok, state, error, nxt = uu.transact(link, frame, uu.CMD_BEGIN)
+        if not ok:
+            sys.exit("delta at block %d refused (state %s)" % (base, uu.STATES[state]))
+        uu.stream(link, image, nxt, args.window)
+        ok, state, error, nxt = uu.transact(link, uu.frame(uu.CMD_APPLY), uu.CMD_APPLY)
+        if not ok:
+            sys.exit("apply refused (state %s)" % uu.STATES[state])
+        while state == uu.UPD_APPLYING:
+            time.sleep(0.1)
+            ok, state, error, nxt = uu.transact(link, uu.frame(uu.CMD_STAT), uu.CMD_STAT)
+        if state != uu.UPD_DONE:
+            sys.exit("delta at block %d failed: %s" % (base, uu.ERRORS[error]))
+        print("blocks %s written in %.1f s" % (",".join("%d" % (base + i) for i, _ in items), time.time() - t0))
+
+
+def run_sim(args, todo):
+    out = b""
+    for base, items in todo:
+        image, frame = begin(base, items)
+        out += frame
+        w = 0
+        while w < len(image) // 2:
+            out += uu.data_frame(image, w)
+            w += uu.chunk_words(w)
+        out += uu.frame(uu.CMD_APPLY) + uu.frame(uu.CMD_STAT)
+    with open(args.out, "wb") as f:
+        f.write(out)
+    print("%d bytes of frames -> %s" % (len(out), args.out))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[1].strip())
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    for name in ("diff", "send", "sim"):
+        p = sub.add_parser(name)
+        if name == "send":
+            p.add_argument("port", help="serial port")
+        p.add_argument("old", nargs="?", help="file or DWIN_SET folder in the field")
+        p.add_argument("new", nargs="?", help="file or DWIN_SET folder to install")
+        if name == "sim":
+            p.add_argument("out", help="frame file for T5L_SIM_RX_FILE")
+        p.add_argument("--manifest", help="asset_build.py delta manifest instead of OLD and NEW")
+        p.add_argument("--id", type=int, help="DWIN_SET file ID (default: leading number of the name)")
+        p.add_argument("--baud", type=int, default=115200)
+        p.add_argument("--window", type=int, default=4, help="unacknowledged chunks in flight")
+    args = ap.parse_args()
+    if args.cmd == "sim" and args.manifest and args.old and not args.new:
+        # sim --manifest FILE OUT: the only positional is the frame file
+        args.out, args.old = args.old, None
+    if bool(args.manifest) == bool(args.old and args.new):
+        ap.error("give OLD and NEW, or --manifest")
+
+    todo = plan(args)
+    if args.cmd == "send" and todo:
+        run_serial(args, todo)
+    elif args.cmd == "sim":
+        run_sim(args, todo)
+
+
+if __name__ == "__main__":
+    main()
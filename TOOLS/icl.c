@@ -0,0 +1,558 @@
+/**
+ * @file icl.c
+ * @brief DGUS ICL Icon Library Packer/Unpacker.
+ * @details Builds and takes apart the .icl files of DGUS/DWIN_SET (16.icl from
+ *          DGUS/image, 30.icl from DGUS/ICON or DGUS/30) without the vendor tool:
+ *
+ *              icl pack   OUT.icl DIR [-q quality] [-j jobs]
+ *              icl unpack IN.icl DIR
+ *              icl list   IN.icl
+ *
+ *          pack takes every BMP/PNG/JPEG in DIR whose name starts with the icon ID
+ *          ("100_btn_dnd_0.png" is icon 100). Baseline JPEGs are stored as they
+ *          are; all other images are encoded with libjpeg on -j worker threads
+ *          (default: one per CPU). Icons that end up byte-identical are stored
+ *          once and share an index slot. A table of per-icon sizes is printed.
+ *
+ *          File layout (as written by the DGUS tool):
+ *          - 0x00  "DGUS_3"
+ *          - 0x06  CRC16 (Modbus, low byte first) of bytes 0x08 to the end
+ *          - 0x08  File length - 8, big-endian u32
+ *          - 0x0C  Format 4 (JPEG), 0x0E last icon ID; u16, low byte first
+ *          - 0x10  Entry offset per icon ID 0..last, big-endian u32, 0 = no icon
+ *          - Entries, 4-byte aligned: W(2) H(2) HDR(2) DATA(4), then the JPEG
+ *            split after the SOS segment into HDR header bytes and DATA bytes of
+ *            scan data, EOI and at least 8 zero bytes. The SOS segment is padded
+ *            so that the scan data starts 4-byte aligned.
+ */
+
+#include "img.h"
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef unsigned char  u8;
+typedef unsigned short u16;
+typedef unsigned int   u32;
+
+// --- ICL Constants ---
+#define ICL_MAGIC           "DGUS_3"
+#define ICL_HEAD            16          // Header bytes before the index
+#define ICL_FORMAT_JPEG     4
+#define ICL_ENTRY_HEAD      10          // W H HDR DATA
+#define ICL_TAIL_ZEROS      8           // Zero bytes after EOI
+#define ICL_MAX_ID          0xFFFF
+#define ICL_QUALITY         90          // Quality of the vendor tool's 16.icl
+
+typedef struct
+{
+    int     id;
+    char    path[PATH_MAX];
+    int     w;
+    int     h;
+    u8*     entry;                      // ICL entry (header + JPEG + padding)
+    size_t  len;
+    int     copied;                     // 1 = JPEG stored as it was
+    int     dup;                        // Job with identical entry, or -1
+    u32     offset;
+    char    err[PATH_MAX + 64];
+} icl_job;
+
+static icl_job* jobs;
+static int job_count;
+static int job_next;
+static int quality = ICL_QUALITY;
+
+// --- Helpers ---
+
+static u16 be16(const u8* p) { return (p[0] << 8) | p[1]; }
+static u32 be32(const u8* p) { return ((u32)be16(p) << 16) | be16(p + 2); }
+static void put16(u8* p, u16 v) { p[0] = v >> 8; p[1] = v; }
+static void put32(u8* p, u32 v) { put16(p, v >> 16); put16(p + 2, v); }
+
+static u16 crc16(const u8* buf, size_t len)
+{
+    u16 crc = 0xFFFF;
+    int i;
+    while (len--)
+    {
+        crc ^= *buf++;
+        for (i = 0; i < 8; i++)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+    return crc;
+}
+
+static double now_ms(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1e6;
+}
+
+static void die(const char* fmt, const char* arg)
+{
+    fprintf(stderr, "icl: ");
+    fprintf(stderr, fmt, arg);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+// --- JPEG Layout ---
+
+/**
+ * @brief Split a JPEG into header (SOI..SOS) and scan data (..EOI)
+ * @return 0 if it is a single-scan baseline JPEG the ICL can hold, -1 otherwise
+ */
+static int jpeg_split(const u8* d, size_t len, size_t* hdr_end, size_t* scan_end, int* w, int* h)
+{
+    size_t p = 2, i;
+    int comps = 0;
+
+    if (len < 4 || d[0] != 0xFF || d[1] != 0xD8)
+        return -1;
+    while (p + 4 <= len)
+    {
+        u8 m = d[p + 1];
+        size_t seg = be16(d + p + 2);
+        if (d[p] != 0xFF || seg < 2 || p + 2 + seg > len)
+            return -1;
+        if (m == 0xC0)
+        {
+            *h = be16(d + p + 5);
+            *w = be16(d + p + 7);
+            comps = d[p + 9];
+        }
+        else if (m == 0xDA)
+        {
+            if (!comps || d[p + 4] != comps)
+                return -1;
+            *hdr_end = p + 2 + seg;
+            for (i = *hdr_end; i + 1 < len; i++)
+                if (d[i] == 0xFF && d[i + 1] == 0xD9)
+                {
+                    *scan_end = i + 2;
+                    return 0;
+                }
+            return -1;
+        }
+        else if (!((m >= 0xE0 && m <= 0xEF) || m == 0xFE || m == 0xDB || m == 0xC4))
+            return -1;                  // Progressive, arithmetic, restart markers...
+        p += 2 + seg;
+    }
+    return -1;
+}
+
+/** Build the ICL entry of a baseline JPEG */
+static int entry_build(icl_job* j, const u8* d, size_t len)
+{
+    size_t hdr, scan, pad, data, sos = 2;
+    u8* e;
+
+    if (jpeg_split(d, len, &hdr, &scan, &j->w, &j->h))
+        return -1;
+    while (d[sos + 1] != 0xDA)
+        sos += 2 + be16(d + sos + 2);
+    pad = (4 - (ICL_ENTRY_HEAD + hdr) % 4) % 4;
+    data = (scan - hdr + ICL_TAIL_ZEROS + 3) & ~(size_t)3;
+    j->len = ICL_ENTRY_HEAD + hdr + pad + data;
+    j->entry = e = calloc(1, j->len);
+    put16(e, j->w);
+    put16(e + 2, j->h);
+    put16(e + 4, hdr + pad);
+    put32(e + 6, data);
+    memcpy(e + ICL_ENTRY_HEAD, d, hdr);
+    // SOS is the last header segment: the pad bytes extend it
+    put16(e + ICL_ENTRY_HEAD + sos + 2, be16(d + sos + 2) + pad);
+    memcpy(e + ICL_ENTRY_HEAD + hdr + pad, d + hdr, scan - hdr);
+    return 0;
+}
+
+/** Rebuild a standard JPEG from an ICL entry (SOS padding and zero tail removed) */
+static u8* entry_jpeg(const u8* e, size_t avail, size_t* out_len)
+{
+    size_t hdr, data, p = 2, seg, i, n;
+    u8* out;
+
+    if (avail < ICL_ENTRY_HEAD)
+        return NULL;
+    hdr = be16(e + 4);
+    data = be32(e + 6);
+    e += ICL_ENTRY_HEAD;
+    if (hdr < 4 || ICL_ENTRY_HEAD + hdr + data > avail || e[0] != 0xFF || e[1] != 0xD8)
+        return NULL;
+    while (p + 4 <= hdr && e[p + 1] != 0xDA)
+        p += 2 + be16(e + p + 2);
+    if (p + 4 > hdr)
+        return NULL;
+    // Standard SOS length: 6 + 2 per component
+    seg = 6 + 2 * e[p + 4];
+    out = malloc(p + 2 + seg + data);
+    memcpy(out, e, p + 2 + seg);
+    put16(out + p + 2, seg);
+    n = p + 2 + seg;
+    for (i = 0; i + 1 < data; i++)
+        if (e[hdr + i] == 0xFF && e[hdr + i + 1] == 0xD9)
+            break;
+    data = i + 1 < data ? i + 2 : data;
+    memcpy(out + n, e + hdr, data);
+    *out_len = n + data;
+    return out;
+}
+
+// --- Pack ---
+
+static const char* ext(const char* name)
+{
+    const char* dot = strrchr(name, '.');
+    return dot ? dot + 1 : "";
+}
+
+static int is_jpeg(const char* name)
+{
+    return !strcasecmp(ext(name), "jpg") || !strcasecmp(ext(name), "jpeg");
+}
+
+static int is_image(const char* name)
+{
+    return is_jpeg(name) || !strcasecmp(ext(name), "bmp") || !strcasecmp(ext(name), "png");
+}
+
+static void pack_one(icl_job* j)
+{
+    img_rgb img;
+    u8* jpeg = NULL;
+    size_t len;
+
+    if (is_jpeg(j->path))
+    {
+        jpeg = img_read_file(j->path, &len);
+        if (jpeg && entry_build(j, jpeg, len) == 0)
+        {
+            j->copied = 1;
+            free(jpeg);
+            return;
+        }
+        free(jpeg);
+        jpeg = NULL;
+    }
+    if (img_load(j->path, &img, j->err, sizeof(j->err)))
+        return;
+    if (img_encode_jpeg(&img, quality, &jpeg, &len) || entry_build(j, jpeg, len))
+        snprintf(j->err, sizeof(j->err), "%s: JPEG encoding failed", j->path);
+    img_free(&img);
+    free(jpeg);
+}
+
+static void* pack_worker(void* arg)
+{
+    int i;
+    (void)arg;
+    while ((i = __sync_fetch_and_add(&job_next, 1)) < job_count)
+        pack_one(&jobs[i]);
+    return NULL;
+}
+
+static int job_cmp(const void* a, const void* b)
+{
+    const icl_job* x = a;
+    const icl_job* y = b;
+    return x->id != y->id ? x->id - y->id : strcmp(x->path, y->path);
+}
+
+static void scan_dir(const char* dir)
+{
+    DIR* d = opendir(dir);
+    struct dirent* de;
+    int cap = 0, i, n;
+
+    if (!d)
+        die("cannot open %s", dir);
+    while ((de = readdir(d)))
+    {
+        char* end;
+        long id = strtol(de->d_name, &end, 10);
+        if (de->d_name[0] < '0' || de->d_name[0] > '9' || id > ICL_MAX_ID || !is_image(de->d_name))
+            continue;
+        if (job_count == cap)
+            jobs = realloc(jobs, (cap = cap ? cap * 2 : 64) * sizeof(*jobs));
+        memset(&jobs[job_count], 0, sizeof(*jobs));
+        jobs[job_count].id = (int)id;
+        jobs[job_count].dup = -1;
+        snprintf(jobs[job_count].path, PATH_MAX, "%s/%s", dir, de->d_name);
+        job_count++;
+    }
+    closedir(d);
+    qsort(jobs, job_count, sizeof(*jobs), job_cmp);
+
+    // One file per ID: the first in name order
+    for (i = n = 0; i < job_count; i++)
+    {
+        if (n && jobs[n - 1].id == jobs[i].id)
+        {
+            fprintf(stderr, "icl: %s skipped, icon %d is %s\n", jobs[i].path, jobs[i].id, jobs[n - 1].path);
+            continue;
+        }
+        jobs[n++] = jobs[i];
+    }
+    job_count = n;
+    if (!job_count)
+        die("no numbered images in %s", dir);
+}
+
+/** Mark entries identical to an earlier one (FNV-1a hash, then memcmp) */
+static int dedup(void)
+{
+    u32* hash = malloc(job_count * sizeof(u32));
+    int i, k, unique = 0;
+
+    for (i = 0; i < job_count; i++)
+    {
+        u32 h = 2166136261u;
+        size_t n;
+        for (n = 0; n < jobs[i].len; n++)
+            h = (h ^ jobs[i].entry[n]) * 16777619u;
+        hash[i] = h;
+        for (k = 0; k < i; k++)
+            if (jobs[k].dup < 0 && hash[k] == h && jobs[k].len == jobs[i].len &&
+                !memcmp(jobs[k].entry, jobs[i].entry, jobs[i].len))
+            {
+                jobs[i].dup = k;
+                break;
+            }
+        unique += jobs[i].dup < 0;
+    }
+    free(hash);
+    return unique;
+}
+
+static int cmd_pack(const char* out, const char* dir, int threads)
+{
+    pthread_t* tid;
+    int i, unique, last, errors = 0;
+    size_t size;
+    double t0, t1;
+    u8* file;
+    u32 pos;
+    FILE* f;
+
+    scan_dir(dir);
+    if (threads > job_count)
+        threads = job_count;
+    tid = malloc(threads * sizeof(*tid));
+
+    t0 = now_ms();
+    for (i = 0; i < threads; i++)
+        pthread_create(&tid[i], NULL, pack_worker, NULL);
+    for (i = 0; i < threads; i++)
+        pthread_join(tid[i], NULL);
+    t1 = now_ms();
+    free(tid);
+
+    for (i = 0; i < job_count; i++)
+        if (jobs[i].err[0])
+        {
+            fprintf(stderr, "icl: %s\n", jobs[i].err);
+            errors++;
+        }
+    if (errors)
+        return 1;
+
+    unique = dedup();
+    last = jobs[job_count - 1].id;
+    pos = ICL_HEAD + 4 * (last + 1);
+    for (i = 0; i < job_count; i++)
+        if (jobs[i].dup < 0)
+        {
+            jobs[i].offset = pos;
+            pos += jobs[i].len;
+        }
+    size = pos;
+    file = calloc(1, size);
+    memcpy(file, ICL_MAGIC, 6);
+    put32(file + 8, size - 8);
+    file[12] = ICL_FORMAT_JPEG;
+    file[14] = last;
+    file[15] = last >> 8;
+    for (i = 0; i < job_count; i++)
+    {
+        icl_job* j = &jobs[i];
+        u32 ofs = j->dup < 0 ? j->offset : jobs[j->dup].offset;
+        put32(file + ICL_HEAD + 4 * j->id, ofs);
+        if (j->dup < 0)
+            memcpy(file + ofs, j->entry, j->len);
+        printf("%5d  %4dx%-4d %7lu  %-8s %s", j->id, j->w, j->h, (unsigned long)j->len,
+               j->dup >= 0 ? "shared" : j->copied ? "copied" : "encoded", j->path);
+        if (j->dup >= 0)
+            printf(" (= icon %d)", jobs[j->dup].id);
+        printf("\n");
+    }
+    {
+        u16 crc = crc16(file + 8, size - 8);
+        file[6] = crc;
+        file[7] = crc >> 8;
+    }
+
+    f = fopen(out, "wb");
+    if (!f || fwrite(file, 1, size, f) != size || fclose(f))
+        die("cannot write %s", out);
+    printf("%s: %d icons, %d stored, %lu bytes, encoded in %.0f ms on %d threads\n",
+           out, job_count, unique, (unsigned long)size, t1 - t0, threads > 0 ? threads : 1);
+    free(file);
+    return 0;
+}
+
+// --- Read ---
+
+typedef struct
+{
+    u8*     d;
+    size_t  len;
+    int     last;
+} icl_file;
+
+static void icl_open(const char* path, icl_file* f)
+{
+    u16 crc;
+
+    f->d = img_read_file(path, &f->len);
+    if (!f->d)
+        die("cannot read %s", path);
+    if (f->len < ICL_HEAD || memcmp(f->d, ICL_MAGIC, 6))
+        die("%s: not a DGUS ICL file", path);
+    f->last = f->d[14] | (f->d[15] << 8);
+    if (ICL_HEAD + 4 * (size_t)(f->last + 1) > f->len)
+        die("%s: truncated index", path);
+    crc = crc16(f->d + 8, f->len - 8);
+    if (be32(f->d + 8) != f->len - 8 || (f->d[6] | (f->d[7] << 8)) != crc)
+        fprintf(stderr, "icl: %s: length or CRC mismatch (damaged file?)\n", path);
+}
+
+static u32 icl_offset(const icl_file* f, int id)
+{
+    return be32(f->d + ICL_HEAD + 4 * id);
+}
+
+static int cmd_list(const char* path)
+{
+    icl_file f;
+    int id, k, icons = 0;
+    size_t used = 0;
+
+    icl_open(path, &f);
+    for (id = 0; id <= f.last; id++)
+    {
+        u32 ofs = icl_offset(&f, id);
+        const u8* e = f.d + ofs;
+        size_t len;
+        if (!ofs)
+            continue;
+        icons++;
+        if (ofs + ICL_ENTRY_HEAD > f.len)
+        {
+            printf("%5d  offset 0x%X outside the file\n", id, ofs);
+            continue;
+        }
+        len = ICL_ENTRY_HEAD + be16(e + 4) + be32(e + 6);
+        for (k = 0; k < id && icl_offset(&f, k) != ofs; k++)
+            ;
+        printf("%5d  %4dx%-4d %7lu  @0x%06X", id, be16(e), be16(e + 2), (unsigned long)len, ofs);
+        if (k < id)
+            printf(" (= icon %d)", k);
+        else
+            used += len;
+        printf("\n");
+    }
+    printf("%s: %d icons, IDs 0..%d, %lu bytes (%lu in entries)\n",
+           path, icons, f.last, (unsigned long)f.len, (unsigned long)used);
+    free(f.d);
+    return 0;
+}
+
+static int cmd_unpack(const char* path, const char* dir)
+{
+    icl_file f;
+    int id, n = 0;
+
+    icl_open(path, &f);
+    if (mkdir(dir, 0777) && errno != EEXIST)
+        die("cannot create %s", dir);
+    for (id = 0; id <= f.last; id++)
+    {
+        u32 ofs = icl_offset(&f, id);
+        char name[PATH_MAX];
+        size_t len;
+        u8* jpeg;
+        FILE* out;
+
+        if (!ofs)
+            continue;
+        jpeg = ofs < f.len ? entry_jpeg(f.d + ofs, f.len - ofs, &len) : NULL;
+        if (!jpeg)
+        {
+            fprintf(stderr, "icl: %s: icon %d is damaged\n", path, id);
+            continue;
+        }
+        snprintf(name, sizeof(name), "%s/%d.jpg", dir, id);
+        out = fopen(name, "wb");
+        if (!out || fwrite(jpeg, 1, len, out) != len || fclose(out))
+            die("cannot write %s", name);
+        printf("%5d  %4dx%-4d %7lu  %s\n", id, be16(f.d + ofs), be16(f.d + ofs + 2), (unsigned long)len, name);
+        free(jpeg);
+        n++;
+    }
+    printf("%s: %d icons unpacked to %s\n", path, n, dir);
+    free(f.d);
+    return 0;
+}
+
+// --- Main ---
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: icl pack OUT.icl DIR [-q quality] [-j jobs]\n"
+            "       icl unpack IN.icl DIR\n"
+            "       icl list IN.icl\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+
+    if (argc < 3)
+        usage();
+    optind = 2;
+    while ((opt = getopt(argc, argv, "q:j:")) != -1)
+    {
+        if (opt == 'q')
+            quality = atoi(optarg);
+        else if (opt == 'j')
+            threads = atoi(optarg);
+        else
+            usage();
+    }
+    if (threads < 1)
+        threads = 1;
+    if (quality < 1 || quality > 100)
+        usage();
+
+    if (!strcmp(argv[1], "pack") && argc - optind == 2)
+        return cmd_pack(argv[optind], argv[optind + 1], threads);
+    if (!strcmp(argv[1], "unpack") && argc - optind == 2)
+        return cmd_unpack(argv[optind], argv[optind + 1]);
+    if (!strcmp(argv[1], "list") && argc - optind == 1)
+        return cmd_list(argv[optind]);
+    usage();
+    return 2;
+}
@@ -0,0 +1,285 @@
+/**
+ * @file img.c
+ * @brief Host Image Loader for the DGUS Asset Tools.
+ * @details BMP is parsed here; PNG and JPEG go through libpng and libjpeg.
+ */
+
+#include "img.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+#include <png.h>
+
+// --- Helpers ---
+
+static unsigned rd16(const unsigned char* p) { return p[0] | (p[1] << 8); }
+static unsigned long rd32(const unsigned char* p) { return rd16(p) | ((unsigned long)rd16(p + 2) << 16); }
+
+static int fail(char* err, size_t err_len, const char* path, const char* what)
+{
+    snprintf(err, err_len, "%s: %s", path, what);
+    return -1;
+}
+
+static const char* ext(const char* path)
+{
+    const char* dot = strrchr(path, '.');
+    return dot ? dot + 1 : "";
+}
+
+/** Channel position of an 8-bit BMP bit mask, -1 if it is not a whole byte */
+static int mask_shift(unsigned long mask)
+{
+    int s;
+    for (s = 0; s < 32; s += 8)
+        if (mask == (0xFFUL << s))
+            return s;
+    return -1;
+}
+
+unsigned char* img_read_file(const char* path, size_t* len)
+{
+    FILE* f = fopen(path, "rb");
+    unsigned char* buf;
+    long n;
+
+    if (!f)
+        return NULL;
+    fseek(f, 0, SEEK_END);
+    n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buf = malloc(n > 0 ? n : 1);
+    if (buf && fread(buf, 1, n, f) != (size_t)n)
+    {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *len = n;
+    return buf;
+}
+
+// --- BMP ---
+
+static int load_bmp(const char* path, img_rgb* img, char* err, size_t err_len)
+{
+    size_t len;
+    unsigned char* d = img_read_file(path, &len);
+    unsigned long off, hdr, comp, stride;
+    unsigned long mr = 0x00FF0000, mg = 0x0000FF00, mb = 0x000000FF, ma = 0;
+    int w, h, bpp, sr, sg, sb, sa, top_down, x, y, opaque = 1;
+
+    if (!d)
+        return fail(err, err_len, path, "cannot read");
+    if (len < 54 || d[0] != 'B' || d[1] != 'M')
+    {
+        free(d);
+        return fail(err, err_len, path, "not a BMP file");
+    }
+    off = rd32(d + 10);
+    hdr = rd32(d + 14);
+    w = (int)rd32(d + 18);
+    h = (int)rd32(d + 22);
+    bpp = rd16(d + 28);
+    comp = rd32(d + 30);
+    top_down = h < 0;
+    if (top_down)
+        h = -h;
+    if (comp == 3 && len >= 14 + 40 + 12)
+    {
+        // BI_BITFIELDS: masks follow the 40-byte header (inside it for V4/V5)
+        mr = rd32(d + 54);
+        mg = rd32(d + 58);
+        mb = rd32(d + 62);
+        ma = (hdr >= 56 && len >= 70) ? rd32(d + 66) : 0;
+    }
+    else if (bpp == 32)
+        ma = 0xFF000000;
+    sr = mask_shift(mr);
+    sg = mask_shift(mg);
+    sb = mask_shift(mb);
+    sa = ma ? mask_shift(ma) : -1;
+    stride = ((unsigned long)w * bpp / 8 + 3) & ~3UL;
+    if (w <= 0 || h <= 0 || !(bpp == 24 || bpp == 32) || !(comp == 0 || comp == 3) ||
+        sr < 0 || sg < 0 || sb < 0 || off + stride * h > len)
+    {
+        free(d);
+        return fail(err, err_len, path, "unsupported BMP (24/32-bit uncompressed only)");
+    }
+
+    img->w = w;
+    img->h = h;
+    img->rgb = malloc((size_t)w * h * 3);
+    // 32-bit files with an all-zero alpha channel are opaque
+    if (bpp == 32 && sa >= 0)
+        for (y = 0; y < h && opaque; y++)
+            for (x = 0; x < w; x++)
+                if (d[off + y * stride + x * 4 + sa / 8])
+                {
+                    opaque = 0;
+                    break;
+                }
+    for (y = 0; y < h; y++)
+    {
+        const unsigned char* src = d + off + (top_down ? y : h - 1 - y) * stride;
+        unsigned char* dst = img->rgb + (size_t)y * w * 3;
+        for (x = 0; x < w; x++, dst += 3)
+        {
+            if (bpp == 24)
+            {
+                dst[0] = src[x * 3 + 2];
+                dst[1] = src[x * 3 + 1];
+                dst[2] = src[x * 3];
+            }
+            else
+            {
+                const unsigned char* p = src + x * 4;
+                unsigned a = (opaque || sa < 0) ? 255 : p[sa / 8];
+                dst[0] = p[sr / 8] * a / 255;
+                dst[1] = p[sg / 8] * a / 255;
+                dst[2] = p[sb / 8] * a / 255;
+            }
+        }
+    }
+    free(d);
+    return 0;
+}
+
+// --- PNG ---
+
+static int load_png(const char* path, img_rgb* img, char* err, size_t err_len)
+{
+    png_image png;
+    png_color black = { 0, 0, 0 };
+
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&png, path))
+        return fail(err, err_len, path, png.message);
+    png.format = PNG_FORMAT_RGB;
+    img->w = png.width;
+    img->h = png.height;
+    img->rgb = malloc(PNG_IMAGE_SIZE(png));
+    // Without an alpha channel in the output format libpng composites over `black`
+    if (!png_image_finish_read(&png, &black, img->rgb, 0, NULL))
+    {
+        img_free(img);
+        return fail(err, err_len, path, png.message);
+    }
+    return 0;
+}
+
+// --- JPEG ---
+
+typedef struct
+{
+    struct jpeg_error_mgr pub;
+    jmp_buf               jump;
+    char                  text[JMSG_LENGTH_MAX];
+} jpeg_err;
+
+static void jpeg_fail(j_common_ptr cinfo)
+{
+    jpeg_err* e = (jpeg_err*)cinfo->err;
+    e->pub.format_message(cinfo, e->text);
+    longjmp(e->jump, 1);
+}
+
+static int load_jpeg(const char* path, img_rgb* img, char* err, size_t err_len)
+{
+    struct jpeg_decompress_struct cinfo;
+    jpeg_err jerr;
+    size_t len;
+    unsigned char* d = img_read_file(path, &len);
+
+    if (!d)
+        return fail(err, err_len, path, "cannot read");
+    img->rgb = NULL;
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = jpeg_fail;
+    if (setjmp(jerr.jump))
+    {
+        jpeg_destroy_decompress(&cinfo);
+        free(d);
+        img_free(img);
+        return fail(err, err_len, path, jerr.text);
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, d, len);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&cinfo);
+    img->w = cinfo.output_width;
+    img->h = cinfo.output_height;
+    img->rgb = malloc((size_t)img->w * img->h * 3);
+    while (cinfo.output_scanline < cinfo.output_height)
+    {
+        JSAMPROW row = img->rgb + (size_t)cinfo.output_scanline * img->w * 3;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    free(d);
+    return 0;
+}
+
+int img_encode_jpeg(const img_rgb* img, int quality, unsigned char** out, size_t* out_len)
+{
+    struct jpeg_compress_struct cinfo;
+    jpeg_err jerr;
+    unsigned long n = 0;
+
+    *out = NULL;
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = jpeg_fail;
+    if (setjmp(jerr.jump))
+    {
+        jpeg_destroy_compress(&cinfo);
+        free(*out);
+        *out = NULL;
+        return -1;
+    }
+    jpeg_create_compress(&cinfo);
+    jpeg_mem_dest(&cinfo, out, &n);
+    cinfo.image_width = img->w;
+    cinfo.image_height = img->h;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, quality, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < cinfo.image_height)
+    {
+        JSAMPROW row = img->rgb + (size_t)cinfo.next_scanline * img->w * 3;
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    *out_len = n;
+    return 0;
+}
+
+// --- Public ---
+
+int img_load(const char* path, img_rgb* img, char* err, size_t err_len)
+{
+    const char* e = ext(path);
+
+    img->rgb = NULL;
+    if (!strcasecmp(e, "bmp"))
+        return load_bmp(path, img, err, err_len);
+    if (!strcasecmp(e, "png"))
+        return load_png(path, img, err, err_len);
+    if (!strcasecmp(e, "jpg") || !strcasecmp(e, "jpeg"))
+        return load_jpeg(path, img, err, err_len);
+    return fail(err, err_len, path, "unknown image type");
+}
+
+void img_free(img_rgb* img)
+{
+    free(img->rgb);
+    img->rgb = NULL;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file img.h
+ * @brief Host Image Loader for the DGUS Asset Tools.
+ * @details Decodes the source formats of the DGUS project folders into packed
+ *          RGB888 (R, G, B byte order, top row first):
+ *          - BMP: uncompressed 24-bit, 32-bit BI_RGB or BI_BITFIELDS (8 bits per
+ *            channel), bottom-up or top-down
+ *          - PNG: any type libpng reads
+ *          - JPEG: any type libjpeg reads
+ *          Alpha is composited over black, which the DGUS icon controls filter
+ *          as background.
+ */
+
+#ifndef __IMG_H__
+#define __IMG_H__
+
+#include <stddef.h>
+
+typedef struct
+{
+    int            w;
+    int            h;
+    unsigned char* rgb;     /**< w * h * 3 bytes */
+} img_rgb;
+
+/**
+ * @brief Decode an image file by its extension (.bmp, .png, .jpg, .jpeg)
+ * @param path File name
+ * @param img Filled with a malloc'ed pixel buffer on success
+ * @param err Error text on failure
+ * @param err_len Size of err
+ * @return 0 on success, -1 on failure
+ */
+int img_load(const char* path, img_rgb* img, char* err, size_t err_len);
+
+/**
+ * @brief Encode RGB888 as a baseline JPEG (4:2:0, standard Huffman tables)
+ * @param img Source image
+ * @param quality libjpeg quality 1..100
+ * @param out malloc'ed JPEG stream on success
+ * @param out_len Stream length
+ * @return 0 on success, -1 on failure
+ */
+int img_encode_jpeg(const img_rgb* img, int quality, unsigned char** out, size_t* out_len);
+
+/**
+ * @brief Read a whole file
+ * @param path File name
+ * @param len File length
+ * @return malloc'ed contents, NULL on failure
+ */
+unsigned char* img_read_file(const char* path, size_t* len);
+
+/**
+ * @brief Release the pixel buffer
+ */
+void img_free(img_rgb* img);
+
+#endif
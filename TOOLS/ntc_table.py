@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""
+NTC lookup table generator for KEIL/ntc.c.
+
+Reads AMBIENT_NTC_RREF / AMBIENT_NTC_B_VALUE / AMBIENT_NTC_PULLUP from
+KEIL/DWIN_GUI_VP.h, evaluates the Beta equation (the float reference the
+firmware used before, ROOM_GetTemperature()) at every segment boundary of the
+16-bit ADC range and writes KEIL/ntc_table.h.
+
+The firmware interpolates linearly between two entries, so before writing the
+table the script replays that integer interpolation for every ADC code and
+checks the error against the float reference: above MAX_ERROR in the quoted
+range the header is not written and the script exits with status 1.
+Regenerate whenever the NTC constants change:
+
+    python3 TOOLS/ntc_table.py            check, write KEIL/ntc_table.h
+    python3 TOOLS/ntc_table.py --check    only check (exit status 1 on failure)
+"""
+
+import math
+import os
+import re
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+VP_HEADER = os.path.join(ROOT, "KEIL", "DWIN_GUI_VP.h")
+OUT = os.path.join(ROOT, "KEIL", "ntc_table.h")
+
+SHIFT = 9                         # must match NTC_TABLE_SHIFT in ntc.h
+SEGMENTS = 65536 >> SHIFT
+T_MIN, T_MAX = -9999, 9999        # NTC_OPEN / NTC_SHORT results, centi-degrees
+ENTRY_LIMIT = 32000               # table entries, kept off the s16 edges
+REPORT_RANGE = (-2000, 10000)     # range the accuracy figure is quoted for
+MAX_ERROR = 10                    # centi-degrees allowed in REPORT_RANGE (0.1 C)
+
+
+def read_constants():
+    text = open(VP_HEADER, encoding="utf-8", errors="replace").read()
+    consts = {}
+    for name in ("AMBIENT_NTC_RREF", "AMBIENT_NTC_B_VALUE", "AMBIENT_NTC_PULLUP"):
+        m = re.search(r"#define\s+%s\s+([0-9.]+)f?" % name, text)
+        if not m:
+            sys.exit("ntc_table.py: %s not found in %s" % (name, VP_HEADER))
+        consts[name] = float(m.group(1))
+    return consts
+
+
+def reference(adc, c):
+    """Float reference, same formula and guards as the old ROOM_GetTemperature()."""
+    if adc >= 65534:
+        return -99.99
+    if adc == 0:
+        return 99.99
+    r = c["AMBIENT_NTC_PULLUP"] * ((65535.0 / (65535.0 - adc)) - 1.0)
+    b = c["AMBIENT_NTC_B_VALUE"]
+    return (b * 298.15) / (b + 298.15 * math.log(r / c["AMBIENT_NTC_RREF"])) - 273.15
+
+
+def build_table(c):
+    table = []
+    for i in range(SEGMENTS + 1):
+        adc = min(i << SHIFT, 65533)
+        t = int(round(reference(max(adc, 1), c) * 100.0))
+        table.append(max(-ENTRY_LIMIT, min(ENTRY_LIMIT, t)))
+    return table
+
+
+def interpolate(table, adc):
+    """Integer replay of NTC_GetTemperature() in KEIL/ntc.c."""
+    if adc >= 65534:
+        return T_MIN
+    if adc == 0:
+        return T_MAX
+    i = adc >> SHIFT
+    frac = adc & ((1 << SHIFT) - 1)
+    a, b = table[i], table[i + 1]
+    d = (b - a) * frac
+    # C51 signed shift is arithmetic, like Python's
+    t = a + (d >> SHIFT)
+    return max(T_MIN, min(T_MAX, t))
+
+
+def report(table, c):
+    worst = 0.0
+    worst_adc = 0
+    for adc in range(1, 65534):
+        ref = reference(adc, c) * 100.0
+        if not (REPORT_RANGE[0] <= ref <= REPORT_RANGE[1]):
+            continue
+        err = abs(interpolate(table, adc) - ref)
+        if err > worst:
+            worst, worst_adc = err, adc
+    print("ntc_table: %d entries, max error %.2f C at ADC %u (%.1f..%.1f C)"
+          % (len(table), worst / 100.0, worst_adc,
+             REPORT_RANGE[0] / 100.0, REPORT_RANGE[1] / 100.0))
+    return worst
+
+
+def write_header(table, c):
+    lines = [
+        "/**",
+        " * @file ntc_table.h",
+        " * @brief NTC ADC -> centi-degree table, generated by TOOLS/ntc_table.py.",
+        " * @details Do not edit. RREF %g, B %g, PULLUP %g; entry i is the temperature"
+        % (c["AMBIENT_NTC_RREF"], c["AMBIENT_NTC_B_VALUE"], c["AMBIENT_NTC_PULLUP"]),
+        " *          at ADC code (i << NTC_TABLE_SHIFT). Included by ntc.c only.",
+        " */",
+        "",
+        "#ifndef __NTC_TABLE_H__",
+        "#define __NTC_TABLE_H__",
+        "",
+        "static code s16 ntc_table[NTC_TABLE_SIZE] =",
+        "{",
+    ]
+    for i in range(0, len(table), 8):
+        row = ", ".join("%6d" % v for v in table[i:i + 8])
+        lines.append("    " + row + ("," if i + 8 < len(table) else ""))
+    lines += ["};", "", "#endif", ""]
+    with open(OUT, "w", newline="\n") as f:
+        f.write("\n".join(lines))
+
+
+def main():
+    c = read_constants()
+    table = build_table(c)
+    worst = report(table, c)
+    if worst > MAX_ERROR:
+        sys.exit("ntc_table: max error %.2f C exceeds %.2f C" % (worst / 100.0, MAX_ERROR / 100.0))
+    if "--check" not in sys.argv[1:]:
+        write_header(table, c)
+
+
+if __name__ == "__main__":
+    main()
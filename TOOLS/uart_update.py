@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+"""
+UART5 streaming update sender for KEIL/update.c.
+
+Streams an image into the DGUS RAM staging window with the framed protocol of
+KEIL/proto.h (commands 0xA0-0xA4), asks the firmware to verify the CRC16 and
+apply it, and reports the result:
+
+    --target code   8051 code, padded to 64 KB; applied with VP 0x0006 and a
+                    reset through VP 0x0004
+    --target flash  NOR flash from --block on, padded to whole 32 KB blocks
+
+Chunks are sent back to back, never across a 32 KB block boundary, with up to --window of them unacknowledged. Every
+reply carries the firmware's contiguous high-water mark, so a lost or refused
+chunk only rewinds the stream to that point. Running the tool again with the
+same image resumes an interrupted transfer. Offsets on the wire are the low 16
+bits of the word position; both sides extend them from the high-water mark.
+TOOLS/flash_delta.py drives the third target (delta) with the same helpers.
+
+    python3 TOOLS/uart_update.py /dev/ttyUSB0 Demo.bin
+    python3 TOOLS/uart_update.py /dev/ttyUSB0 16.icl --target flash --block 0x80
+    python3 TOOLS/uart_update.py --sim small.bin --target flash --block 0x80
+        (prints the frames as a T5L_SIM_RX string for SIM/build/t5l_sim)
+
+Needs pyserial for a real port.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+HEAD = b"\x5a\xa5"
+CMD_BEGIN, CMD_DATA, CMD_STAT, CMD_APPLY, CMD_ABORT = 0xA0, 0xA1, 0xA2, 0xA3, 0xA4
+TARGETS = {"code": 0, "flash": 1, "delta": 2}
+CHUNK = 248                       # LEN = CMD + OFS + 248 + CRC = 253 <= 255
+CODE_BYTES = 65536
+BLOCK_BYTES = 32768
+BLOCK_WORDS = BLOCK_BYTES // 2
+
+STATES = ["idle", "receiving", "verifying", "applying", "done", "error"]
+ERRORS = ["none", "crc mismatch", "not an 8051 image", "flash write timeout"]
+UPD_RECEIVING, UPD_VERIFYING, UPD_APPLYING, UPD_DONE, UPD_ERROR = 1, 2, 3, 4, 5
+
+
+def crc16(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def frame(cmd, payload=b""):
+    body = bytes([cmd]) + payload
+    return HEAD + bytes([len(body) + 2]) + body + struct.pack("<H", crc16(body))
+
+
+def load_image(path, target):
+    data = open(path, "rb").read()
+    if target == "code":
+        if len(data) > CODE_BYTES:
+            sys.exit("%s: %d bytes, code images are at most 64 KB" % (path, len(data)))
+        return data + b"\xff" * (CODE_BYTES - len(data))
+    if len(data) > CODE_BYTES:
+        sys.exit("%s: %d bytes, one session stages at most 64 KB" % (path, len(data)))
+    return data + b"\xff" * (-len(data) % BLOCK_BYTES)
+
+
+def begin_frame(image, target, block, blocks=b""):
+    """`blocks`: IDX CRC_H CRC_L per streamed block (delta target only)."""
+    return frame(CMD_BEGIN, struct.pack(">BIHH", TARGETS[target], len(image), crc16(image), block) + blocks)
+
+
+def chunk_words(word):
+    """Words in the chunk at `word`: CHUNK, cut at the next 32 KB block."""
+    return min(CHUNK // 2, BLOCK_WORDS - word % BLOCK_WORDS)
+
+
+def data_frame(image, word):
+    return frame(CMD_DATA, struct.pack(">H", word & 0xFFFF) + image[word * 2:(word + chunk_words(word)) * 2])
+
+
+def extend(acked, nxt):
+    """Full word position of a 16-bit NEXT, taken as the one closest to `acked`."""
+    return acked + ((nxt - acked + 0x8000) & 0xFFFF) - 0x8000
+
+
+class Link:
+    """Frame reader on top of a pyserial port."""
+
+    def __init__(self, port, baud):
+        import serial
+        self.ser = serial.Serial(port, baud, timeout=0.05)
+        self.buf = b""
+
+    def send(self, data):
+        self.ser.write(data)
+
+    def reply(self, timeout):
+        """Next valid frame as (cmd, payload), or None on timeout."""
+        end = time.time() + timeout
+        while time.time() < end:
+            self.buf += self.ser.read(256)
+            while True:
+                i = self.buf.find(HEAD)
+                if i < 0 or len(self.buf) < i + 3:
+                    break
+                n = self.buf[i + 2]
+                if len(self.buf) < i + 3 + n:
+                    break
+                body, self.buf = self.buf[i + 3:i + 3 + n], self.buf[i + 3 + n:]
+                if n >= 3 and crc16(body[:-2]) == struct.unpack("<H", body[-2:])[0]:
+                    return body[0], body[1:-2]
+        return None
+
+
+def status(payload):
+    ok, state, error, nxt = struct.unpack(">BBBH", payload[:5])
+    return ok, state, error, nxt
+
+
+def transact(link, data, cmd, tries=5):
+    for _ in range(tries):
+        link.send(data)
+        r = link.reply(0.5)
+        while r and r[0] != cmd:
+            r = link.reply(0.5)
+        if r:
+            if len(r[1]) < 5:
+                sys.exit("command 0x%02X refused as malformed" % cmd)
+            return status(r[1])
+    sys.exit("no reply to command 0x%02X" % cmd)
+
+
+def stream(link, image, start, window):
+    """Send all chunks from word `start` on; returns the final high-water mark."""
+    words = len(image) // 2
+    sent = acked = start
+    inflight = 0
+    last = time.time()
+    while acked < words:
+        while inflight < window and sent < words:
+            link.send(data_frame(image, sent))
+            sent += chunk_words(sent)
+            inflight += 1
+        r = link.reply(0.5)
+        if r is None:
+            if time.time() - last > 2:
+                sys.exit("transfer stalled at word 0x%04X" % acked)
+            sent, inflight = acked, 0           # lost reply or chunk: rewind
+            continue
+        if r[0] != CMD_DATA:
+            continue
+        last = time.time()
+        ok, state, error, nxt = status(r[1])
+        if state != UPD_RECEIVING:
+            sys.exit("session left the receiving state (%s, %s)" % (STATES[state], ERRORS[error]))
+        inflight = max(inflight - 1, 0)
+        acked = max(acked, extend(acked, nxt))
+        if not ok:
+            if sent > acked:
+                time.sleep(0.02)                # staging buffer still being flashed
+            sent, inflight = acked, 0           # gap: rewind to the high-water mark
+        print("\r%5.1f%%" % (100.0 * acked / words), end="", flush=True)
+    print()
+    return acked
+
+
+def run_serial(args, image):
+    link = Link(args.port, args.baud)
+    t0 = time.time()
+
+    ok, state, error, nxt = transact(link, begin_frame(image, args.target, args.block), CMD_BEGIN)
+    if not ok:
+        sys.exit("update refused (state %s)" % STATES[state])
+    if nxt:
+        print("resuming at byte %d" % (nxt * 2))
+
+    stream(link, image, nxt, args.window)
+    secs = time.time() - t0
+    print("%d bytes in %.1f s, %.0f B/s" % (len(image), secs, len(image) / secs))
+
+    ok, state, error, nxt = transact(link, frame(CMD_APPLY), CMD_APPLY)
+    if not ok:
+        sys.exit("apply refused (state %s, %d bytes received)" % (STATES[state], nxt * 2))
+    while True:
+        time.sleep(0.2)
+        link.send(frame(CMD_STAT))
+        r = link.reply(1.0)
+        if r is None:
+            if args.target == "code" and state == UPD_APPLYING:
+                print("code written, display restarting")
+                return
+            continue
+        if r[0] != CMD_STAT:
+            continue
+        ok, state, error, nxt = status(r[1])
+        if state == UPD_DONE:
+            print("flash written")
+            return
+        if state == UPD_ERROR:
+            sys.exit("update failed: %s (nothing applied)" % ERRORS[error])
+
+
+def run_sim(args, image):
+    frames = [begin_frame(image, args.target, args.block)]
+    w = 0
+    while w < len(image) // 2:
+        frames.append(data_frame(image, w))
+        w += chunk_words(w)
+    frames += [frame(CMD_APPLY), frame(CMD_STAT)]
+    print("".join("\\x%02X" % b for b in b"".join(frames)))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[1].strip())
+    ap.add_argument("port", nargs="?", help="serial port (omit with --sim)")
+    ap.add_argument("image", help="binary image")
+    ap.add_argument("--target", choices=TARGETS, default="code")
+    ap.add_argument("--block", type=lambda s: int(s, 0), default=0, help="first 32 KB flash block")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--window", type=int, default=4, help="unacknowledged chunks in flight")
+    ap.add_argument("--sim", action="store_true", help="print T5L_SIM_RX frames instead of sending")
+    ap.add_argument("--no-pad", action="store_true", help="send the image as is (--sim tests; code images must still be 64 KB, flash images whole blocks)")
+    args = ap.parse_args()
+
+    image = open(args.image, "rb").read() if args.no_pad else load_image(args.image, args.target)
+    if len(image) & 1:
+        image += b"\xff"
+    if args.sim:
+        run_sim(args, image)
+    else:
+        if not args.port:
+            ap.error("a serial port is needed unless --sim is given")
+        run_serial(args, image)
+
+
+if __name__ == "__main__":
+    main()
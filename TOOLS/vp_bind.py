@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+"""
+VP binding table generator for KEIL/vp_bind.c.
+
+Reads the firmware's VP bindings from TOOLS/vp_bind.cfg and the display
+project's control files (DGUS/DWIN_SET/14ShowFile.bin, 13TouchFile.bin, read
+with TOOLS/dgus_map.py), then
+writes KEIL/vp_bind_table.h:
+
+  - VP_<NAME> (address) and VPB_<NAME> (mirror index) for every binding
+  - the bindings sorted by VP and merged into runs of adjacent VPs with the
+    same policy, which vp_bind.c writes with one access per run
+  - "auto" bindings placed back to back from auto_base, clear of every VP the
+    display project uses, so they form a single run
+  - the VPs the GUI core writes itself (touch controls and shared bindings),
+    which KEIL/dgus.c keeps out of its shadow RAM filter
+
+Each fixed binding is checked against the controls that use its VP: the size
+must match the control's data size, and a VP written by a touch control is
+forced from push to the shared policy. Regenerate whenever the cfg or the DGUS project
+changes:
+
+    python3 TOOLS/vp_bind.py            write KEIL/vp_bind_table.h, print the map
+    python3 TOOLS/vp_bind.py --check    only print the map and warnings
+"""
+
+import os
+import re
+import sys
+
+import dgus_map
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+CFG = os.path.join(ROOT, "TOOLS", "vp_bind.cfg")
+OUT = os.path.join(ROOT, "KEIL", "vp_bind_table.h")
+
+POLICIES = ("push", "shared")
+
+
+def show_controls(folder):
+    """(vp, words, page) of every display control that reads a VP, words None if unknown."""
+    return [(c["vp"], c["words"] if c["sized"] else None, c["page"]) for c in dgus_map.read_show(os.path.join(folder, "14ShowFile.bin"))
+            if c["vp"] is not None]
+
+
+def touch_controls(folder):
+    """(vp, page) of every touch control that writes a VP."""
+    return [(c["vp"], c["page"]) for c in dgus_map.read_touch(os.path.join(folder, "13TouchFile.bin"))
+            if c["vp"] is not None]
+
+
+def read_cfg(path):
+    base = None
+    binds = []
+    for no, line in enumerate(open(path, encoding="utf-8"), 1):
+        text, _, comment = line.partition("#")
+        f = text.split()
+        if not f:
+            continue
+        if f[0] == "auto_base" and len(f) == 2:
+            base = int(f[1], 0)
+            continue
+        if len(f) != 4 or not re.match(r"^[A-Z][A-Z0-9_]*$", f[0]) or f[3] not in POLICIES:
+            sys.exit("%s:%d: expected NAME VP|auto WORDS push|shared" % (path, no))
+        vp = None if f[1] == "auto" else int(f[1], 0)
+        binds.append({"name": f[0], "vp": vp, "words": int(f[2], 0), "policy": f[3],
+                      "comment": comment.strip(), "note": ""})
+    return base, binds
+
+
+def resolve(base, binds, show, touch):
+    """Check fixed bindings against the controls, place the auto ones."""
+    warnings = []
+    written = {vp for vp, _ in touch}
+    for b in binds:
+        if b["vp"] is None:
+            continue
+        users = [c for c in show if c[0] == b["vp"]]
+        for vp, words, page in users:
+            if words is None:
+                warnings.append("%s: VP 0x%04X is shown on page %d by a control of unknown size, check %d word(s)"
+                                % (b["name"], vp, page, b["words"]))
+            elif words != b["words"]:
+                warnings.append("%s: VP 0x%04X is %d word(s) on page %d, bound as %d"
+                                % (b["name"], vp, words, page, b["words"]))
+        notes = ["page %d display" % p for _, _, p in users]
+        if b["vp"] in written:
+            notes.append("touch")
+            if b["policy"] == "push":
+                b["policy"] = "shared"
+                warnings.append("%s: VP 0x%04X is written by a touch control, made shared"
+                                % (b["name"], b["vp"]))
+        b["note"] = ", ".join(notes) if notes else "no DWIN_SET control"
+
+    used = set()
+    for vp, words, _ in show:
+        used.update(range(vp, vp + (words or 1)))
+    used.update(written)
+    for b in binds:
+        if b["vp"] is not None:
+            used.update(range(b["vp"], b["vp"] + b["words"]))
+
+    auto = [b for b in binds if b["vp"] is None]
+    if auto:
+        if base is None:
+            sys.exit("vp_bind.cfg: auto bindings need auto_base")
+        need = sum(b["words"] for b in auto)
+        vp = base
+        while any(v in used for v in range(vp, vp + need)):
+            vp += 1
+        for b in auto:
+            b["vp"], b["note"] = vp, "auto"
+            vp += b["words"]
+
+    binds.sort(key=lambda b: b["vp"])
+    for a, b in zip(binds, binds[1:]):
+        if a["vp"] + a["words"] > b["vp"]:
+            sys.exit("vp_bind.cfg: %s and %s overlap" % (a["name"], b["name"]))
+    return warnings
+
+
+def build_runs(binds):
+    """Mirror indices and runs of adjacent VPs with one policy."""
+    runs = []
+    index = 0
+    for b in binds:
+        b["index"] = index
+        r = runs[-1] if runs else None
+        if r and r["vp"] + r["words"] == b["vp"] and r["policy"] == b["policy"]:
+            r["words"] += b["words"]
+        else:
+            runs.append({"vp": b["vp"], "first": index, "words": b["words"], "policy": b["policy"]})
+        index += b["words"]
+    return runs, index
+
+
+def gui_ranges(binds, touch):
+    """(vp, words) runs of every VP the GUI core writes: touch controls and shared bindings."""
+    vps = {vp for vp, _ in touch}
+    for b in binds:
+        if b["policy"] != "push":
+            vps.update(range(b["vp"], b["vp"] + b["words"]))
+    out = []
+    for vp in sorted(vps):
+        if out and out[-1][0] + out[-1][1] == vp:
+            out[-1][1] += 1
+        else:
+            out.append([vp, 1])
+    return out
+
+
+def write_header(binds, runs, words, gui):
+    shared = [0] * ((words + 7) // 8)
+    for b in binds:
+        if b["policy"] != "push":
+            for i in range(b["index"], b["index"] + b["words"]):
+                shared[i >> 3] |= 1 << (i & 7)
+
+    lines = [
+        "/**",
+        " * @file vp_bind_table.h",
+        " * @brief VP binding table, generated by TOOLS/vp_bind.py.",
+        " * @details Do not edit. Source: TOOLS/vp_bind.cfg checked against",
+        " *          DGUS/DWIN_SET/14ShowFile.bin and 13TouchFile.bin. Included by vp_bind.h.",
+        " */",
+        "",
+        "#ifndef __VP_BIND_TABLE_H__",
+        "#define __VP_BIND_TABLE_H__",
+        "",
+        "// --- Bindings: VP address and mirror index ---",
+    ]
+    for b in binds:
+        lines.append("#define %-23s 0x%04X  // %s%s" % ("VP_" + b["name"], b["vp"], b["policy"],
+                     ", " + b["note"] + (" - " + b["comment"] if b["comment"] else "")))
+        lines.append("#define %-23s %d" % ("VPB_" + b["name"], b["index"]))
+    lines += [
+        "",
+        "#define VPB_COUNT               %d" % len(binds),
+        "#define VPB_WORDS               %d" % words,
+        "#define VPB_RUNS                %d" % len(runs),
+        "#define VPB_RUN_MAX             %d" % max(r["words"] for r in runs),
+        "",
+        "// Runs of adjacent VPs with one policy: { VP, first index, words, policy }",
+        "#define VPB_RUN_TABLE \\",
+        "{ \\",
+    ]
+    for i, r in enumerate(runs):
+        lines.append("    { 0x%04X, %d, %d, %s }%s \\" % (r["vp"], r["first"], r["words"],
+                     "VPB_" + r["policy"].upper(), "," if i + 1 < len(runs) else ""))
+    lines += [
+        "}",
+        "",
+        "// Shared words (written on every set), one bit per mirror index",
+        "#define VPB_SHARED_BITS         { %s }" % ", ".join("0x%02X" % v for v in shared),
+        "",
+        "// VPs the GUI core writes (touch controls, shared bindings): { VP, words }",
+        "#define VPB_GUI_COUNT           %d" % len(gui),
+        "#define VPB_GUI_TABLE           { %s }" % ", ".join("{ 0x%04X, %d }" % (v, n) for v, n in gui),
+        "",
+        "#endif",
+        "",
+    ]
+    with open(OUT, "w", newline="\n") as f:
+        f.write("\n".join(lines))
+
+
+def main():
+    base, binds = read_cfg(CFG)
+    show = show_controls(dgus_map.DWIN_SET)
+    touch = touch_controls(dgus_map.DWIN_SET)
+    warnings = resolve(base, binds, show, touch)
+    runs, words = build_runs(binds)
+
+    for b in binds:
+        print("0x%04X %-14s %d word(s) %-6s %s" % (b["vp"], b["name"], b["words"], b["policy"], b["note"]))
+    bound = {v for b in binds for v in range(b["vp"], b["vp"] + b["words"])}
+    for vp in sorted({c[0] for c in show} | {t[0] for t in touch}):
+        if vp not in bound:
+            print("0x%04X (not bound)                    display project only" % vp)
+    for w in warnings:
+        print("warning: " + w)
+    gui = gui_ranges(binds, touch)
+    print("vp_bind: %d bindings, %d words, %d runs, %d GUI-written range(s)" % (len(binds), words, len(runs), len(gui)))
+
+    if "--check" not in sys.argv[1:]:
+        write_header(binds, runs, words, gui)
+
+
+if __name__ == "__main__":
+    main()